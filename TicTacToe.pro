@@ -4,40 +4,30 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-TARGET = TicTacToeNew
-TEMPLATE = app
-
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which has been marked as deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-
-SOURCES += \
-        main.cpp \
-        mainwindow.cpp \
-    board.cpp \
-    ai.cpp \
-    gamestate.cpp
-
-HEADERS += \
-        mainwindow.h \
-    board.h \
-    ai.h \
-    gamestate.h
-
-FORMS += \
-        mainwindow.ui
-
-RESOURCES += \
-    menu_icons.qrc
+# The engine is a static library without Qt; the game and the tools link it.
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    engine \
+    app \
+    gauntlet \
+    pnsolver \
+    ntupletrain \
+    batchanalyze \
+    renderbench \
+    gamestatetest
+
+gauntlet.subdir = tools/gauntlet
+pnsolver.subdir = tools/pnsolver
+ntupletrain.subdir = tools/ntupletrain
+batchanalyze.subdir = tools/batchanalyze
+renderbench.subdir = tools/renderbench
+gamestatetest.subdir = tests/gamestate
+
+app.depends = engine
+gauntlet.depends = engine
+pnsolver.depends = engine
+ntupletrain.depends = engine
+batchanalyze.depends = engine
+renderbench.depends = engine
+gamestatetest.depends = engine
@@ -0,0 +1,310 @@
+#include "ai.h"
+#include "trace.h"
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+constexpr int kInfinity = 1e6;
+// The clock is read once per this many nodes.
+constexpr uint64_t kTimeCheckInterval = 1024;
+
+namespace ai {
+
+namespace {
+
+bool ProbeResult(SearchContext* context, uint64_t key, int depth, TranspositionEntry* entry) {
+    if (context->table != nullptr && context->table->Probe(key, depth, entry)) {
+        return true;
+    }
+    if (context->persistent_cache != nullptr &&
+            context->persistent_cache->Probe(key, depth, entry)) {
+        if (context->table != nullptr) {
+            context->table->Store(key, *entry);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Moves searched below the root. Minimax does not prune, so their order does
+// not matter.
+template <typename BoardType>
+std::vector<Move> GenSearchMoves(const BoardType& board, const SearchContext*) {
+    return board.GenValidMoves();
+}
+
+std::vector<Move> GenSearchMoves(const Board& board, const SearchContext* context) {
+    if (context != nullptr && context->use_candidate_moves) {
+        return board.GenCandidateMoves();
+    }
+    return board.GenValidMoves();
+}
+
+// Moves searched at the root, where ties go to the first best move.
+template <typename BoardType>
+std::vector<Move> GenRootMoves(const BoardType& board, Piece, const SearchContext*) {
+    return board.GenValidMoves();
+}
+
+std::vector<Move> GenRootMoves(const Board& board, Piece piece, const SearchContext* context) {
+    if (context != nullptr && context->use_candidate_moves) {
+        return board.GenOrderedCandidateMoves(piece);
+    }
+    return board.GenValidMoves();
+}
+
+void StoreResult(SearchContext* context, uint64_t key, const TranspositionEntry& entry) {
+    if (context->table != nullptr) {
+        context->table->Store(key, entry);
+    }
+    if (context->persistent_cache != nullptr && entry.depth >= kMinPersistentDepth) {
+        context->persistent_cache->Store(key, entry);
+    }
+}
+
+}
+
+void SearchContext::SetTimeLimit(int time_ms) {
+    has_deadline = true;
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_ms);
+}
+
+bool SearchContext::IsStopped() {
+    if (is_aborted) {
+        return true;
+    }
+    if ((stop != nullptr && stop->load(std::memory_order_relaxed)) ||
+            (max_nodes != 0 && nodes >= max_nodes) ||
+            (has_deadline && nodes % kTimeCheckInterval == 0 &&
+             std::chrono::steady_clock::now() >= deadline)) {
+        is_aborted = true;
+    }
+    return is_aborted;
+}
+
+template <typename BoardType>
+Move GetRandomeMove(const BoardType& board, std::mt19937* rng) {
+    TRACE_SCOPE("engine", "ai::GetRandomeMove");
+    auto valid_moves = board.GenValidMoves();
+    assert(!valid_moves.empty());
+    std::uniform_int_distribution<size_t> distribution(0, valid_moves.size() - 1);
+    return valid_moves[distribution(*rng)];
+}
+
+template <typename BoardType>
+Move GetMinimaxMove(SideToMove side, BoardType& board, int depth, SearchContext* context) {
+    TRACE_SCOPE("engine", "ai::GetMinimaxMove");
+    Move best_move;
+    int best_score = -kInfinity;
+    Piece piece = (side == SideToMove::X) ? Piece::X : Piece::O;
+    Piece opposite_piece = (piece == Piece::X) ? Piece::O : Piece::X;
+    std::vector<Move> valid_moves = GenRootMoves(board, piece, context);
+    // Ties go to the best of the candidate order, else to a random move if
+    // there is a generator to pick it.
+    if (context != nullptr && context->rng != nullptr && !context->use_candidate_moves) {
+        std::shuffle(valid_moves.begin(), valid_moves.end(), *context->rng);
+    }
+    assert(!valid_moves.empty());
+    for (const Move& curr_move : valid_moves) {
+        board.MakeMove(curr_move, piece);
+        int curr_score = Minimax(opposite_piece, board, depth - 1, false, context);
+        board.UnmakeMove(curr_move);
+        if (curr_score > best_score) {
+            best_score = curr_score;
+            best_move = curr_move;
+        }
+    }
+    if (context != nullptr && !context->IsStopped()) {
+        StoreResult(context, board.Hash(), TranspositionEntry(best_score, depth, best_move));
+    }
+    return best_move;
+}
+
+template <typename BoardType>
+int Minimax(Piece piece, BoardType& board, int depth, bool is_maximizing, SearchContext* context) {
+    if (context != nullptr) {
+        ++context->nodes;
+        if (context->IsStopped()) {
+            return 0;
+        }
+    }
+    Piece opposite_piece = (piece == Piece::X) ? Piece::O : Piece::X;
+    if (depth == 0 || board.IsTerminalNode()) {
+        int sign = is_maximizing ? -1 : 1;
+        // Here we pass opposite_piece to EvalBoard() because if we are in the leaf node with
+        // O to move, it means that last move was made by X and it is not possible for O to be
+        // a winner of the game.
+        return sign * board.EvalBoard(opposite_piece);
+    }
+    TranspositionEntry entry;
+    if (context != nullptr && ProbeResult(context, board.Hash(), depth, &entry)) {
+        return is_maximizing ? entry.score : -entry.score;
+    }
+    int best_score = is_maximizing ? -kInfinity : kInfinity;
+    Move best_move;
+    std::vector<Move> valid_moves = GenSearchMoves(board, context);
+    if (is_maximizing) {
+        for (const Move& curr_move : valid_moves) {
+            board.MakeMove(curr_move, piece);
+            int curr_score = Minimax(opposite_piece, board, depth - 1, !is_maximizing, context);
+            board.UnmakeMove(curr_move);
+            if (curr_score > best_score) {
+                best_score = curr_score;
+                best_move = curr_move;
+            }
+        }
+    } else {
+        for (const auto& curr_move : valid_moves) {
+            board.MakeMove(curr_move, piece);
+            int curr_score = Minimax(opposite_piece, board, depth - 1, !is_maximizing, context);
+            board.UnmakeMove(curr_move);
+            if (curr_score < best_score) {
+                best_score = curr_score;
+                best_move = curr_move;
+            }
+        }
+    }
+    // A stopped search returns made-up scores, which must not be cached.
+    if (context != nullptr && !context->IsStopped()) {
+        StoreResult(context, board.Hash(), TranspositionEntry(is_maximizing ? best_score : -best_score,
+                                                              depth, best_move));
+    }
+    return best_score;
+}
+
+template <typename BoardType>
+Move GetEngineMove(SideToMove side, BoardType& board, const EngineConfig& config,
+                   SearchContext* context) {
+    if (config.algorithm == AiAlgorithm::kRandom) {
+        std::mt19937 local_rng;
+        return GetRandomeMove(board, (context != nullptr && context->rng != nullptr) ?
+                                  context->rng : &local_rng);
+    }
+    SearchContext local_context;
+    if (context == nullptr) {
+        context = &local_context;
+    }
+    // The context may come from an earlier search that was cut short; only
+    // the limits of this one apply.
+    context->is_aborted = false;
+    context->has_deadline = false;
+    context->max_nodes = 0;
+    context->use_candidate_moves = config.use_candidate_moves;
+    if (config.max_nodes == 0 && config.max_time_ms == 0) {
+        return GetMinimaxMove(side, board, config.depth, context);
+    }
+    context->max_nodes = (config.max_nodes != 0) ? context->nodes + config.max_nodes : 0;
+    if (config.max_time_ms != 0) {
+        context->SetTimeLimit(config.max_time_ms);
+    }
+    // Fall back to the first move searched if not even the depth 1 search
+    // finishes.
+    Move best_move = GenRootMoves(board, side == SideToMove::X ? Piece::X : Piece::O,
+                                  context).front();
+    int max_depth = std::min(config.depth, board.NumSquares() - board.NumPieces());
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        Move move = GetMinimaxMove(side, board, depth, context);
+        if (context->IsStopped()) {
+            break;
+        }
+        best_move = move;
+    }
+    return best_move;
+}
+
+namespace {
+
+// Minimax with alpha-beta pruning, scored for the side to move (piece). A
+// score inside (alpha, beta) is exact, one at or below alpha is an upper bound
+// and one at or above beta a lower bound. Only exact scores are cached, so the
+// table holds the same scores as after Minimax().
+template <typename BoardType>
+int AlphaBeta(Piece piece, BoardType& board, int depth, int alpha, int beta,
+              SearchContext* context) {
+    ++context->nodes;
+    if (context->IsStopped()) {
+        return 0;
+    }
+    Piece opposite_piece = (piece == Piece::X) ? Piece::O : Piece::X;
+    if (depth == 0 || board.IsTerminalNode()) {
+        return -board.EvalBoard(opposite_piece);
+    }
+    TranspositionEntry entry;
+    if (ProbeResult(context, board.Hash(), depth, &entry)) {
+        return entry.score;
+    }
+    int best_score = -kInfinity;
+    Move best_move;
+    for (const Move& curr_move : GenSearchMoves(board, context)) {
+        board.MakeMove(curr_move, piece);
+        int curr_score = -AlphaBeta(opposite_piece, board, depth - 1, -beta,
+                                    -std::max(alpha, best_score), context);
+        board.UnmakeMove(curr_move);
+        if (curr_score > best_score) {
+            best_score = curr_score;
+            best_move = curr_move;
+        }
+        if (best_score >= beta) {
+            break;
+        }
+    }
+    if (!context->IsStopped() && best_score > alpha && best_score < beta) {
+        StoreResult(context, board.Hash(), TranspositionEntry(best_score, depth, best_move));
+    }
+    return best_score;
+}
+
+}
+
+template <typename BoardType>
+std::vector<RootMoveScore> AnalyzeRoot(SideToMove side, BoardType& board, int depth,
+                                   SearchContext* context, bool is_bounded) {
+    TRACE_SCOPE("engine", "ai::AnalyzeRoot");
+    TranspositionTable local_table;
+    SearchContext local_context;
+    if (context == nullptr) {
+        context = &local_context;
+    }
+    if (context->table == nullptr) {
+        context->table = &local_table;
+    }
+    Piece piece = (side == SideToMove::X) ? Piece::X : Piece::O;
+    Piece opposite_piece = (piece == Piece::X) ? Piece::O : Piece::X;
+    std::vector<RootMoveScore> scores;
+    int best_score = -kInfinity;
+    for (const Move& curr_move : board.GenValidMoves()) {
+        // A move that only ties the best one still gets its exact score.
+        int alpha = (is_bounded && !scores.empty()) ? best_score - 1 : -kInfinity;
+        board.MakeMove(curr_move, piece);
+        // Without a bound alpha-beta prunes little and caches less than
+        // Minimax, which stores every score it finds.
+        int curr_score = (alpha == -kInfinity) ?
+                    Minimax(opposite_piece, board, depth - 1, false, context) :
+                    -AlphaBeta(opposite_piece, board, depth - 1, -kInfinity, -alpha, context);
+        board.UnmakeMove(curr_move);
+        scores.push_back(RootMoveScore(curr_move, curr_score, depth));
+        scores.back().is_upper_bound = curr_score <= alpha;
+        best_score = std::max(best_score, curr_score);
+    }
+    if (context->table == &local_table) {
+        context->table = nullptr;
+    }
+    std::stable_sort(scores.begin(), scores.end(), [](const RootMoveScore& lhs, const RootMoveScore& rhs) {
+        return lhs.score > rhs.score;
+    });
+    return scores;
+}
+
+#define INSTANTIATE_SEARCH(BoardType) \
+    template Move GetRandomeMove(const BoardType&, std::mt19937*); \
+    template Move GetMinimaxMove(SideToMove, BoardType&, int, SearchContext*); \
+    template int Minimax(Piece, BoardType&, int, bool, SearchContext*); \
+    template Move GetEngineMove(SideToMove, BoardType&, const EngineConfig&, SearchContext*); \
+    template std::vector<RootMoveScore> AnalyzeRoot(SideToMove, BoardType&, int, SearchContext*, bool);
+
+INSTANTIATE_SEARCH(Board)
+INSTANTIATE_SEARCH(QubicBoard)
+INSTANTIATE_SEARCH(UltimateBoard)
+
+}
@@ -0,0 +1,106 @@
+#ifndef AI_H
+#define AI_H
+
+#include "board.h"
+#include "qubicboard.h"
+#include "ultimateboard.h"
+#include "transpositiontable.h"
+#include "persistentcache.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+enum class AiAlgorithm {
+    kRandom,
+    kMinimax
+};
+
+namespace ai {
+constexpr int kDefaultMinimaxDepth = 10;
+// Shallower results are not worth a write to the persistent cache.
+constexpr int kMinPersistentDepth = 2;
+
+// Optional state shared by all nodes of a search. All pointers may be null:
+// without a table nothing is cached, without a stop flag the search runs until
+// it finishes or hits one of its limits (0 means no limit). The persistent
+// cache is consulted after the table and must be open for the board size
+// being searched. Without a random generator the search is deterministic:
+// ties go to the first best move and random moves to a fixed seed.
+struct SearchContext {
+    SearchContext() : table(nullptr), persistent_cache(nullptr), stop(nullptr), rng(nullptr),
+        nodes(0), max_nodes(0), has_deadline(false), is_aborted(false),
+        use_candidate_moves(false) {}
+    void SetTimeLimit(int time_ms);
+    // Once true, stays true: the scores of an aborted search are made up.
+    bool IsStopped();
+    TranspositionTable* table;
+    PersistentCache* persistent_cache;
+    const std::atomic<bool>* stop;
+    // Breaks ties between the root moves and picks the random moves.
+    std::mt19937* rng;
+    uint64_t nodes;
+    uint64_t max_nodes;
+    bool has_deadline;
+    std::chrono::steady_clock::time_point deadline;
+    bool is_aborted;
+    // Search only Board::GenCandidateMoves(), with the root moves in the
+    // order of Board::GenOrderedCandidateMoves() instead of shuffled. Boards of
+    // other types always search every valid move. Results are not comparable with
+    // full-width ones, so a table should not be shared between the two.
+    bool use_candidate_moves;
+};
+
+// How the computer picks its move. A minimax search with a node or time limit
+// deepens iteratively up to depth and plays the move of the deepest search
+// that finished in time.
+struct EngineConfig {
+    EngineConfig() : algorithm(AiAlgorithm::kMinimax), depth(kDefaultMinimaxDepth), max_nodes(0),
+        max_time_ms(0), use_candidate_moves(false) {}
+    AiAlgorithm algorithm;
+    int depth;
+    uint64_t max_nodes;
+    int max_time_ms;
+    // See SearchContext::use_candidate_moves.
+    bool use_candidate_moves;
+};
+
+// Score of a root move from the point of view of the side to move at the root.
+struct RootMoveScore {
+    RootMoveScore() : score(0), depth(0), is_upper_bound(false) {}
+    RootMoveScore(const Move& move_, int score_, int depth_) :
+        move(move_), score(score_), depth(depth_), is_upper_bound(false) {}
+    Move move;
+    int score;
+    int depth;
+    // Set if the move is worse than the best one and score is only the most
+    // it gets, see AnalyzeRoot().
+    bool is_upper_bound;
+};
+
+// The search functions work with any board type that has the interface of
+// Board: Board, QubicBoard and UltimateBoard are instantiated in ai.cpp.
+template <typename BoardType>
+Move GetRandomeMove(const BoardType& board, std::mt19937* rng);
+template <typename BoardType>
+Move GetMinimaxMove(SideToMove side, BoardType& board, int depth, SearchContext* context = nullptr);
+template <typename BoardType>
+int Minimax(Piece piece, BoardType& board, int depth, bool is_maximizing,
+            SearchContext* context = nullptr);
+// The limits of config replace those left in the context by an earlier search,
+// so one context may serve every move of a game.
+template <typename BoardType>
+Move GetEngineMove(SideToMove side, BoardType& board, const EngineConfig& config,
+                   SearchContext* context = nullptr);
+// Scores every legal move in one search. All root moves share one transposition
+// table (the context's, or a temporary one), so positions reachable from
+// several root moves are searched once. Sorted from best to worst.
+// If is_bounded, the best score so far bounds the search of the later moves:
+// a move that cannot reach it only gets an upper bound, which is much cheaper
+// than its exact score. The best moves and those tying them are always exact.
+template <typename BoardType>
+std::vector<RootMoveScore> AnalyzeRoot(SideToMove side, BoardType& board, int depth,
+                                       SearchContext* context = nullptr, bool is_bounded = false);
+}
+#endif // AI_H
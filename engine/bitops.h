@@ -0,0 +1,33 @@
+#ifndef BITOPS_H
+#define BITOPS_H
+
+#include <cstdint>
+
+// Bit counting for the bitboards. GCC and Clang have single-instruction
+// builtins; other compilers get the portable loops.
+inline int PopCount(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// bits must not be 0.
+inline int CountTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    for (; (bits & 1) == 0; bits >>= 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+#endif // BITOPS_H
@@ -0,0 +1,470 @@
+#include "board.h"
+#include "ntuple.h"
+#include "bitops.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+// Scales the n-tuple network output, which is trained towards +-1, to the
+// range of EvalBoard() scores.
+constexpr int kNTupleEvalScale = kWinEval / 2;
+// GenOrderedCandidateMoves() puts wins and blocks ahead of any move that only
+// extends open lines.
+constexpr int kWinningMoveOrder = 1 << 24;
+constexpr int kBlockingMoveOrder = 1 << 20;
+
+// Everything about a board that depends only on its dimensions. Shared by all
+// boards of the same size and never freed.
+struct BoardGeometry {
+    BoardGeometry(int num_rows_, int num_cols_, int win_length_);
+    int num_rows;
+    int num_cols;
+    int win_length;
+    int num_line_patterns;
+    // Pattern codes of a line full of X and full of O.
+    int x_line_code;
+    int o_line_code;
+    // Number of X and O pieces in a line with the given pattern code.
+    std::vector<int> x_counts;
+    std::vector<int> o_counts;
+    std::vector<std::vector<int>> lines;
+    // For every square: the lines passing through it and the place value of
+    // the square in each line's pattern code.
+    std::vector<std::vector<std::pair<int, int>>> square_lines;
+    // For every square: the other squares within kCandidateRadius.
+    std::vector<std::vector<int>> square_neighbors;
+    std::vector<uint64_t> x_keys;
+    std::vector<uint64_t> o_keys;
+};
+
+BoardGeometry::BoardGeometry(int num_rows_, int num_cols_, int win_length_) :
+    num_rows(num_rows_),
+    num_cols(num_cols_),
+    win_length(win_length_),
+    num_line_patterns(IntPow(3, win_length_)),
+    x_line_code((IntPow(3, win_length_) - 1) / 2),
+    o_line_code(IntPow(3, win_length_) - 1)
+{
+    const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    for (const auto& direction : directions) {
+        for (int row = 0; row < num_rows; ++row) {
+            for (int col = 0; col < num_cols; ++col) {
+                int last_row = row + (win_length - 1) * direction[0];
+                int last_col = col + (win_length - 1) * direction[1];
+                if (last_row < 0 || last_row >= num_rows || last_col < 0 || last_col >= num_cols) {
+                    continue;
+                }
+                std::vector<int> line;
+                for (int i = 0; i < win_length; ++i) {
+                    line.push_back((row + i * direction[0]) * num_cols + col + i * direction[1]);
+                }
+                lines.push_back(line);
+            }
+        }
+    }
+    square_lines.resize(num_rows * num_cols);
+    for (int line = 0; line < static_cast<int>(lines.size()); ++line) {
+        for (int i = 0; i < win_length; ++i) {
+            square_lines[lines[line][i]].push_back(std::make_pair(line, IntPow(3, i)));
+        }
+    }
+    for (int code = 0; code < num_line_patterns; ++code) {
+        int x_count = 0;
+        int o_count = 0;
+        for (int digits = code; digits > 0; digits /= 3) {
+            x_count += (digits % 3 == 1) ? 1 : 0;
+            o_count += (digits % 3 == 2) ? 1 : 0;
+        }
+        x_counts.push_back(x_count);
+        o_counts.push_back(o_count);
+    }
+    square_neighbors.resize(num_rows * num_cols);
+    for (int row = 0; row < num_rows; ++row) {
+        for (int col = 0; col < num_cols; ++col) {
+            for (int neighbor_row = std::max(0, row - kCandidateRadius);
+                 neighbor_row <= std::min(num_rows - 1, row + kCandidateRadius); ++neighbor_row) {
+                for (int neighbor_col = std::max(0, col - kCandidateRadius);
+                     neighbor_col <= std::min(num_cols - 1, col + kCandidateRadius); ++neighbor_col) {
+                    if (neighbor_row != row || neighbor_col != col) {
+                        square_neighbors[row * num_cols + col].push_back(neighbor_row * num_cols + neighbor_col);
+                    }
+                }
+            }
+        }
+    }
+    std::mt19937_64 gen(kZobristSeed);
+    for (int square = 0; square < num_rows * num_cols; ++square) {
+        x_keys.push_back(gen());
+        o_keys.push_back(gen());
+    }
+}
+
+namespace {
+
+const BoardGeometry* GetGeometry(int num_rows, int num_cols, int win_length) {
+    static std::mutex mutex;
+    static std::unordered_map<int, const BoardGeometry*> geometries;
+    int key = (num_rows * (kMaxBoardSize + 1) + num_cols) * (kMaxWinLength + 1) + win_length;
+    std::lock_guard<std::mutex> lock(mutex);
+    const BoardGeometry*& geometry = geometries[key];
+    if (geometry == nullptr) {
+        geometry = new BoardGeometry(num_rows, num_cols, win_length);
+    }
+    return geometry;
+}
+
+int PieceDigit(Piece piece) {
+    if (piece == Piece::X) {
+        return 1;
+    } else if (piece == Piece::O) {
+        return 2;
+    }
+    return 0;
+}
+
+}
+
+Board::Board(int num_rows, int num_cols, int win_length) :
+    hash(0),
+    num_pieces(0),
+    num_x_lines(0),
+    num_o_lines(0),
+    network(nullptr),
+    network_sum(0)
+{
+    assert(num_rows > 0 && num_rows <= kMaxBoardSize && num_cols > 0 && num_cols <= kMaxBoardSize);
+    assert(win_length > 0 && win_length <= kMaxWinLength &&
+           win_length <= std::max(num_rows, num_cols));
+    geometry = GetGeometry(num_rows, num_cols, win_length);
+    squares.assign(num_rows * num_cols, Piece::NoPiece);
+    line_codes.assign(geometry->lines.size(), 0);
+    num_x_open_lines = num_o_open_lines = static_cast<int>(geometry->lines.size());
+    neighbor_counts.assign(num_rows * num_cols, 0);
+    std::fill(candidates, candidates + kCandidateWords, 0);
+    SetNetwork(ntuple::GetDefaultNetwork());
+}
+
+void Board::Reset() {
+    std::fill(squares.begin(), squares.end(), Piece::NoPiece);
+    hash = 0;
+    num_pieces = 0;
+    num_x_lines = 0;
+    num_o_lines = 0;
+    num_x_open_lines = num_o_open_lines = NumLines();
+    std::fill(line_codes.begin(), line_codes.end(), 0);
+    std::fill(neighbor_counts.begin(), neighbor_counts.end(), 0);
+    std::fill(candidates, candidates + kCandidateWords, 0);
+    network_sum = SumNetworkWeights();
+}
+
+void Board::PrintToConsole() const {
+    for (int row = 0; row < NumRows(); ++row) {
+        std::string curr_row;
+        for (int col = 0; col < NumCols(); ++col) {
+            Piece piece = At(row, col);
+            curr_row += (piece == Piece::X) ? 'X' : (piece == Piece::O) ? 'O' : '_';
+        }
+        std::cout << curr_row << std::endl;
+    }
+}
+
+std::string Board::ToString() const {
+    std::string text;
+    for (Piece piece : squares) {
+        text += (piece == Piece::X) ? 'x' : (piece == Piece::O) ? 'o' : '.';
+    }
+    return text;
+}
+
+bool Board::FromString(const std::string& text) {
+    Reset();
+    if (static_cast<int>(text.size()) != NumSquares()) {
+        return false;
+    }
+    for (int square = 0; square < NumSquares(); ++square) {
+        Move move(square / NumCols(), square % NumCols());
+        if (text[square] == 'x' || text[square] == 'X') {
+            MakeMove(move, Piece::X);
+        } else if (text[square] == 'o' || text[square] == 'O') {
+            MakeMove(move, Piece::O);
+        } else if (text[square] != '.') {
+            Reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+Piece Board::At(int row, int col) const {
+    assert(row >= 0 && row < NumRows() && col >= 0 && col < NumCols());
+    return squares[row * NumCols() + col];
+}
+
+bool Board::CheckWin(const Piece& piece) const {
+    assert(piece != Piece::NoPiece);
+    return (piece == Piece::X ? num_x_lines : num_o_lines) > 0;
+}
+
+bool Board::CheckDraw() const {
+    return num_pieces == NumSquares();
+}
+
+std::vector<Move> Board::GenValidMoves() const {
+    std::vector<Move> valid_moves;
+    valid_moves.reserve(NumSquares() - num_pieces);
+    for (int square = 0; square < NumSquares(); ++square) {
+        if (squares[square] == Piece::NoPiece) {
+            valid_moves.push_back(Move(square / NumCols(), square % NumCols()));
+        }
+    }
+    return valid_moves;
+}
+
+std::vector<Move> Board::GenCandidateMoves() const {
+    if (num_pieces == 0) {
+        return GenValidMoves();
+    }
+    std::vector<Move> moves;
+    for (int word = 0; word < kCandidateWords; ++word) {
+        for (uint64_t bits = candidates[word]; bits != 0; bits &= bits - 1) {
+            int square = word * 64 + CountTrailingZeros(bits);
+            moves.push_back(Move(square / NumCols(), square % NumCols()));
+        }
+    }
+    return moves;
+}
+
+std::vector<Move> Board::GenOrderedCandidateMoves(Piece piece) const {
+    if (num_pieces == 0) {
+        return GenValidMoves();
+    }
+    std::vector<std::pair<int, int>> ordered;
+    for (int word = 0; word < kCandidateWords; ++word) {
+        for (uint64_t bits = candidates[word]; bits != 0; bits &= bits - 1) {
+            int square = word * 64 + CountTrailingZeros(bits);
+            ordered.push_back(std::make_pair(CandidateOrder(square, piece), square));
+        }
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const std::pair<int, int>& lhs,
+                                                       const std::pair<int, int>& rhs) {
+        return lhs.first > rhs.first;
+    });
+    std::vector<Move> moves;
+    moves.reserve(ordered.size());
+    for (const auto& candidate : ordered) {
+        moves.push_back(Move(candidate.second / NumCols(), candidate.second % NumCols()));
+    }
+    return moves;
+}
+
+int Board::CandidateOrder(int square, Piece piece) const {
+    const std::vector<int>& own_counts = (piece == Piece::X) ? geometry->x_counts : geometry->o_counts;
+    const std::vector<int>& opponent_counts = (piece == Piece::X) ? geometry->o_counts : geometry->x_counts;
+    int order = 0;
+    bool is_winning = false;
+    bool is_blocking = false;
+    for (const auto& line : geometry->square_lines[square]) {
+        int code = line_codes[line.first];
+        int own_count = own_counts[code];
+        int opponent_count = opponent_counts[code];
+        if (opponent_count == 0) {
+            is_winning = is_winning || own_count == WinLength() - 1;
+            order += own_count * own_count;
+        }
+        if (own_count == 0) {
+            is_blocking = is_blocking || opponent_count == WinLength() - 1;
+            order += opponent_count * opponent_count;
+        }
+    }
+    return order + (is_winning ? kWinningMoveOrder : 0) + (is_blocking ? kBlockingMoveOrder : 0);
+}
+
+int Board::EvalBoard(Piece piece) const {
+    if (CheckWin(piece)) {
+        return kWinEval;
+    }
+    if (CheckDraw()) {
+        return kDrawEval;
+    }
+    // This piece of code should be reached only if we reached depth == 0 in
+    // the minimax call and the game is not finished. On the classic board
+    // the default minimax depth of 10 always reaches the end of the game, but
+    // depth- and time-limited searches on larger boards do stop early. The
+    // position is then scored by the board's n-tuple network if it has one,
+    // otherwise by counting open lines.
+    int eval = 0;
+    if (network != nullptr) {
+        eval = static_cast<int>(network_sum * kNTupleEvalScale / ntuple::kFixedWeightOne);
+    } else {
+        eval = EvalOpenLines();
+    }
+    eval = std::max(-kWinEval + 1, std::min(kWinEval - 1, eval));
+    return piece == Piece::X ? eval : -eval;
+}
+
+int Board::EvalOpenLines() const {
+    int eval = 0;
+    for (int line = 0; line < NumLines(); ++line) {
+        int x_count = LineCount(line, Piece::X);
+        int o_count = LineCount(line, Piece::O);
+        if (o_count == 0) {
+            eval += x_count * x_count;
+        }
+        if (x_count == 0) {
+            eval -= o_count * o_count;
+        }
+    }
+    return eval;
+}
+
+void Board::SetNetwork(const ntuple::NTupleNetwork* network_) {
+    network = (network_ != nullptr && network_->Matches(*this)) ? network_ : nullptr;
+    network_sum = SumNetworkWeights();
+}
+
+const ntuple::NTupleNetwork* Board::GetNetwork() const {
+    return network;
+}
+
+int64_t Board::SumNetworkWeights() const {
+    int64_t sum = 0;
+    if (network != nullptr) {
+        for (int line = 0; line < NumLines(); ++line) {
+            sum += network->FixedWeight(line, line_codes[line]);
+        }
+    }
+    return sum;
+}
+
+bool Board::IsTerminalNode() const {
+    return num_x_lines > 0 || num_o_lines > 0 || CheckDraw();
+}
+
+void Board::MakeMove(const Move& move, Piece piece) {
+    int square = move.row * NumCols() + move.col;
+    assert(squares[square] == Piece::NoPiece && piece != Piece::NoPiece);
+    squares[square] = piece;
+    hash ^= (piece == Piece::X) ? geometry->x_keys[square] : geometry->o_keys[square];
+    ++num_pieces;
+    int digit = PieceDigit(piece);
+    for (const auto& line : geometry->square_lines[square]) {
+        int& code = line_codes[line.first];
+        // The first piece of a side closes the line for the other side.
+        if (piece == Piece::X && geometry->x_counts[code] == 0) {
+            --num_o_open_lines;
+        } else if (piece == Piece::O && geometry->o_counts[code] == 0) {
+            --num_x_open_lines;
+        }
+        if (network != nullptr) {
+            network_sum -= network->FixedWeight(line.first, code);
+        }
+        code += digit * line.second;
+        if (network != nullptr) {
+            network_sum += network->FixedWeight(line.first, code);
+        }
+        if (code == geometry->x_line_code) {
+            ++num_x_lines;
+        } else if (code == geometry->o_line_code) {
+            ++num_o_lines;
+        }
+    }
+    candidates[square / 64] &= ~(1ULL << (square % 64));
+    for (int neighbor : geometry->square_neighbors[square]) {
+        if (neighbor_counts[neighbor]++ == 0 && squares[neighbor] == Piece::NoPiece) {
+            candidates[neighbor / 64] |= 1ULL << (neighbor % 64);
+        }
+    }
+}
+
+void Board::UnmakeMove(const Move& move) {
+    int square = move.row * NumCols() + move.col;
+    Piece piece = squares[square];
+    assert(piece != Piece::NoPiece);
+    hash ^= (piece == Piece::X) ? geometry->x_keys[square] : geometry->o_keys[square];
+    --num_pieces;
+    int digit = PieceDigit(piece);
+    for (const auto& line : geometry->square_lines[square]) {
+        int& code = line_codes[line.first];
+        if (code == geometry->x_line_code) {
+            --num_x_lines;
+        } else if (code == geometry->o_line_code) {
+            --num_o_lines;
+        }
+        if (network != nullptr) {
+            network_sum -= network->FixedWeight(line.first, code);
+        }
+        code -= digit * line.second;
+        if (network != nullptr) {
+            network_sum += network->FixedWeight(line.first, code);
+        }
+        if (piece == Piece::X && geometry->x_counts[code] == 0) {
+            ++num_o_open_lines;
+        } else if (piece == Piece::O && geometry->o_counts[code] == 0) {
+            ++num_x_open_lines;
+        }
+    }
+    squares[square] = Piece::NoPiece;
+    for (int neighbor : geometry->square_neighbors[square]) {
+        if (--neighbor_counts[neighbor] == 0) {
+            candidates[neighbor / 64] &= ~(1ULL << (neighbor % 64));
+        }
+    }
+    if (neighbor_counts[square] > 0) {
+        candidates[square / 64] |= 1ULL << (square % 64);
+    }
+}
+
+uint64_t Board::Hash() const {
+    return hash;
+}
+
+int Board::NumRows() const {
+    return geometry->num_rows;
+}
+
+int Board::NumCols() const {
+    return geometry->num_cols;
+}
+
+int Board::NumSquares() const {
+    return geometry->num_rows * geometry->num_cols;
+}
+
+int Board::NumPieces() const {
+    return num_pieces;
+}
+
+int Board::WinLength() const {
+    return geometry->win_length;
+}
+
+int Board::NumLines() const {
+    return static_cast<int>(line_codes.size());
+}
+
+int Board::NumLinePatterns() const {
+    return geometry->num_line_patterns;
+}
+
+int Board::LineCode(int line) const {
+    return line_codes[line];
+}
+
+int Board::LineCount(int line, Piece piece) const {
+    assert(piece != Piece::NoPiece);
+    return (piece == Piece::X) ? geometry->x_counts[line_codes[line]] :
+                                 geometry->o_counts[line_codes[line]];
+}
+
+int Board::NumOpenLines(Piece piece) const {
+    assert(piece != Piece::NoPiece);
+    return (piece == Piece::X) ? num_x_open_lines : num_o_open_lines;
+}
+
+const std::vector<std::vector<int>>& Board::GetLines() const {
+    return geometry->lines;
+}
@@ -0,0 +1,134 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Dimensions of the classic game, used by default.
+constexpr int kNumRows = 3;
+constexpr int kNumCols = 3;
+constexpr int kNumSquares = kNumRows * kNumCols;
+constexpr int kWinLength = 3;
+constexpr int kMaxBoardSize = 19;
+constexpr int kMaxWinLength = 6;
+constexpr int kWinEval = 100;
+constexpr int kDrawEval = 0;
+// Candidate moves are the empty squares at most this many rows and columns
+// away from a piece. On the classic board that is every empty square.
+constexpr int kCandidateRadius = 2;
+constexpr int kCandidateWords = (kMaxBoardSize * kMaxBoardSize + 63) / 64;
+// Seed of the Zobrist keys of every board type.
+constexpr uint64_t kZobristSeed = 0x9e3779b97f4a7c15ULL;
+
+constexpr int IntPow(int base, int exp) {
+    return exp == 0 ? 1 : base * IntPow(base, exp - 1);
+}
+
+struct Move {
+    Move() : row(-1), col(-1) {}
+    Move(int row_, int col_) : row(row_), col(col_) {}
+    int row;
+    int col;
+};
+
+enum class Piece {
+    X,
+    O,
+    NoPiece
+};
+
+enum class SideToMove {
+    X,
+    O
+};
+
+struct BoardGeometry;
+
+namespace ntuple {
+class NTupleNetwork;
+}
+
+// A rows x cols board where a player wins by getting win_length pieces in a
+// row, column or diagonal.
+//
+// A line is a window of win_length squares along a row, a column or a
+// diagonal. The contents of every line are kept as a base-3 pattern code
+// (0 - empty, 1 - X, 2 - O, the first square of the line is the least
+// significant digit), updated incrementally by MakeMove() and UnmakeMove().
+class Board {
+public:
+    Board(int num_rows = kNumRows, int num_cols = kNumCols, int win_length = kWinLength);
+//    clear();
+    void Reset();
+    void PrintToConsole() const;
+    // Position as NumSquares() characters in row-major order: 'x', 'o' or '.'.
+    std::string ToString() const;
+    // Replaces the position, returns false (leaving the board empty) if text is
+    // not a valid position for a board of this size.
+    bool FromString(const std::string& text);
+    bool CheckWin(const Piece& piece) const;
+    bool CheckDraw() const;
+    Piece At(int row, int col) const;
+    std::vector<Move> GenValidMoves() const;
+    // Empty squares within kCandidateRadius of a piece, or every square of
+    // the empty board, in row-major order.
+    std::vector<Move> GenCandidateMoves() const;
+    // The candidate moves, those that win for piece first, then the ones that
+    // stop the opponent's win, then the rest by the pieces in their open lines.
+    std::vector<Move> GenOrderedCandidateMoves(Piece piece) const;
+    int EvalBoard(Piece piece) const;
+    // The network EvalBoard() scores unfinished positions with, or null to
+    // count open lines. A board starts with the default network if it was made
+    // for its size and keeps the network's value up to date in MakeMove() and
+    // UnmakeMove(). A network for another board size is not set.
+    void SetNetwork(const ntuple::NTupleNetwork* network_);
+    const ntuple::NTupleNetwork* GetNetwork() const;
+    bool IsTerminalNode() const;
+    void MakeMove(const Move& move, Piece piece);
+    void UnmakeMove(const Move& move);
+    // Zobrist hash of the current position, updated incrementally by MakeMove()
+    // and UnmakeMove(). Keys are generated from a fixed seed, so the hash of a
+    // position is the same in every run of the program.
+    uint64_t Hash() const;
+    int NumRows() const;
+    int NumCols() const;
+    int NumSquares() const;
+    int NumPieces() const;
+    int WinLength() const;
+    int NumLines() const;
+    int NumLinePatterns() const;
+    int LineCode(int line) const;
+    // Number of pieces of the given kind in a line.
+    int LineCount(int line, Piece piece) const;
+    // Lines without an opponent's piece, which piece can still complete.
+    int NumOpenLines(Piece piece) const;
+    // Heuristic score of an unfinished position from X's point of view: the
+    // squared piece counts of the lines each side can still complete.
+    int EvalOpenLines() const;
+    // Squares of every line, as row * NumCols() + col.
+    const std::vector<std::vector<int>>& GetLines() const;
+private:
+    const BoardGeometry* geometry;
+    // Row-major.
+    std::vector<Piece> squares;
+    uint64_t hash;
+    int num_pieces;
+    int num_x_lines;
+    int num_o_lines;
+    int num_x_open_lines;
+    int num_o_open_lines;
+    std::vector<int> line_codes;
+    const ntuple::NTupleNetwork* network;
+    // Sum of the network's fixed-point weights of the line codes.
+    int64_t network_sum;
+    // Number of pieces within kCandidateRadius of every square, and the set of
+    // the empty squares among them with at least one, one bit per square.
+    std::vector<int> neighbor_counts;
+    uint64_t candidates[kCandidateWords];
+
+    int CandidateOrder(int square, Piece piece) const;
+    int64_t SumNetworkWeights() const;
+};
+
+#endif // BOARD_H
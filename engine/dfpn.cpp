@@ -0,0 +1,340 @@
+#include "dfpn.h"
+#include "trace.h"
+#include <algorithm>
+#include <cassert>
+
+constexpr uint32_t kDfpnInfinity = 0x3fffffff;
+constexpr int kBucketSize = 4;
+
+namespace ai {
+
+namespace {
+
+uint32_t SaturatingAdd(uint32_t lhs, uint32_t rhs) {
+    return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(lhs) + rhs, kDfpnInfinity));
+}
+
+Piece Opposite(Piece piece) {
+    return piece == Piece::X ? Piece::O : Piece::X;
+}
+
+// Collects up to two distinct squares where piece completes a line with its
+// next move. Returns how many were found.
+int FindThreats(Piece piece, const Board& board, int* squares) {
+    Piece opposite_piece = Opposite(piece);
+    const std::vector<std::vector<int>>& lines = board.GetLines();
+    int num_threats = 0;
+    for (int line = 0; line < static_cast<int>(lines.size()); ++line) {
+        if (board.LineCount(line, piece) != board.WinLength() - 1 ||
+                board.LineCount(line, opposite_piece) != 0) {
+            continue;
+        }
+        for (int square : lines[line]) {
+            if (board.At(square / board.NumCols(), square % board.NumCols()) != Piece::NoPiece) {
+                continue;
+            }
+            if (num_threats == 0 || squares[0] != square) {
+                squares[num_threats++] = square;
+            }
+            if (num_threats == 2) {
+                return num_threats;
+            }
+        }
+    }
+    return num_threats;
+}
+
+}
+
+DfpnSolver::DfpnSolver(int table_size_in_mb) :
+    generation(0),
+    attacker(Piece::X),
+    nodes(0),
+    max_nodes(0),
+    is_aborted(false),
+    is_proof_size_counted(false),
+    num_entries(0),
+    peak_entries(0)
+{
+    uint64_t num_buckets = std::max<uint64_t>(1, (static_cast<uint64_t>(table_size_in_mb) << 20) /
+                                              (sizeof(Entry) * kBucketSize));
+    table.resize(num_buckets * kBucketSize);
+    ClearTable();
+}
+
+SolveResult DfpnSolver::Solve(SideToMove side, const Board& board, uint64_t max_nodes_) {
+    TRACE_SCOPE("engine", "ai::DfpnSolver::Solve");
+    SolveResult result;
+    Board work_board = board;
+    Piece piece = (side == SideToMove::X) ? Piece::X : Piece::O;
+    nodes = 0;
+    max_nodes = max_nodes_;
+    is_aborted = false;
+    peak_entries = 0;
+    uint32_t phi, delta;
+    // Can the side to move win?
+    attacker = piece;
+    ClearTable();
+    if (!IsTerminal(piece, work_board, &phi, &delta)) {
+        Mid(piece, work_board, kDfpnInfinity, kDfpnInfinity, &phi, &delta);
+    }
+    if (!is_aborted && phi == 0) {
+        result.value = GameValue::kWin;
+    } else if (!is_aborted) {
+        // Can the opponent win? If not, the side to move holds the draw.
+        attacker = Opposite(piece);
+        ClearTable();
+        if (!IsTerminal(piece, work_board, &phi, &delta)) {
+            Mid(piece, work_board, kDfpnInfinity, kDfpnInfinity, &phi, &delta);
+        }
+        if (!is_aborted) {
+            result.value = (phi == 0) ? GameValue::kDraw : GameValue::kLoss;
+        }
+    }
+    result.nodes = nodes;
+    result.peak_entries = peak_entries;
+    result.peak_memory_bytes = peak_entries * sizeof(Entry);
+    if (result.value == GameValue::kUnknown || work_board.IsTerminalNode()) {
+        return result;
+    }
+    // Finding the move may search evicted positions again; that work is not
+    // limited and not counted.
+    max_nodes = 0;
+    uint64_t search_nodes = nodes;
+    if (result.value == GameValue::kLoss) {
+        result.best_move = work_board.GenValidMoves().front();
+    } else {
+        FindProvingMove(piece, work_board, &result.best_move);
+    }
+    if (is_proof_size_counted) {
+        nodes = 0;
+        max_nodes = max_nodes_;
+        std::unordered_set<uint64_t> visited;
+        uint64_t proof_size = CountProofTree(piece, work_board, phi == 0, visited);
+        if (!is_aborted) {
+            result.proof_size = proof_size;
+        }
+    }
+    nodes = search_nodes;
+    return result;
+}
+
+void DfpnSolver::SetCountProofSize(bool count) {
+    is_proof_size_counted = count;
+}
+
+void DfpnSolver::Mid(Piece piece, Board& board, uint32_t th_phi, uint32_t th_delta,
+                     uint32_t* phi, uint32_t* delta) {
+    ++nodes;
+    if (max_nodes != 0 && nodes > max_nodes) {
+        is_aborted = true;
+    }
+    uint64_t nodes_before = nodes;
+    Piece opposite_piece = Opposite(piece);
+    std::vector<Move> valid_moves = GenMoves(piece, board);
+    while (true) {
+        // phi is the smallest delta of a child, delta is the sum of the
+        // children's phi.
+        *phi = kDfpnInfinity;
+        *delta = 0;
+        int best_child = -1;
+        uint32_t best_child_phi = 0;
+        uint32_t second_delta = kDfpnInfinity;
+        for (int i = 0; i < static_cast<int>(valid_moves.size()); ++i) {
+            uint32_t child_phi, child_delta, child_work;
+            board.MakeMove(valid_moves[i], piece);
+            LookUpChild(opposite_piece, board, &child_phi, &child_delta, &child_work);
+            board.UnmakeMove(valid_moves[i]);
+            if (child_delta < *phi) {
+                second_delta = *phi;
+                *phi = child_delta;
+                best_child = i;
+                best_child_phi = child_phi;
+            } else if (child_delta < second_delta) {
+                second_delta = child_delta;
+            }
+            *delta = SaturatingAdd(*delta, child_phi);
+        }
+        if (*phi >= th_phi || *delta >= th_delta || is_aborted) {
+            break;
+        }
+        uint32_t child_th_phi = SaturatingAdd(th_delta - *delta, best_child_phi);
+        uint32_t child_th_delta = std::min(th_phi, SaturatingAdd(second_delta, 1));
+        uint32_t child_phi, child_delta;
+        board.MakeMove(valid_moves[best_child], piece);
+        if (!IsTerminal(opposite_piece, board, &child_phi, &child_delta)) {
+            Mid(opposite_piece, board, child_th_phi, child_th_delta, &child_phi, &child_delta);
+        }
+        board.UnmakeMove(valid_moves[best_child]);
+    }
+    Store(board.Hash(), *phi, *delta, static_cast<uint32_t>(std::min<uint64_t>(nodes - nodes_before + 1,
+                                                                          kDfpnInfinity)));
+}
+
+bool DfpnSolver::IsTerminal(Piece piece, const Board& board, uint32_t* phi, uint32_t* delta) const {
+    if (board.CheckWin(Opposite(piece))) {
+        *phi = kDfpnInfinity;
+        *delta = 0;
+        return true;
+    }
+    if (board.CheckDraw()) {
+        // A draw is a loss for the attacker and a success for the defender.
+        *phi = (piece == attacker) ? kDfpnInfinity : 0;
+        *delta = (piece == attacker) ? 0 : kDfpnInfinity;
+        return true;
+    }
+    int squares[2];
+    if (FindThreats(piece, board, squares) > 0) {
+        *phi = 0;
+        *delta = kDfpnInfinity;
+        return true;
+    }
+    if (board.NumOpenLines(attacker) == 0 || FindThreats(Opposite(piece), board, squares) == 2) {
+        bool is_attacker_lost = board.NumOpenLines(attacker) == 0;
+        bool is_side_to_move_lost = !is_attacker_lost || piece == attacker;
+        *phi = is_side_to_move_lost ? kDfpnInfinity : 0;
+        *delta = is_side_to_move_lost ? 0 : kDfpnInfinity;
+        return true;
+    }
+    return false;
+}
+
+std::vector<Move> DfpnSolver::GenMoves(Piece piece, const Board& board) const {
+    int squares[2];
+    if (FindThreats(piece, board, squares) > 0 || FindThreats(Opposite(piece), board, squares) == 1) {
+        return std::vector<Move>{Move(squares[0] / board.NumCols(), squares[0] % board.NumCols())};
+    }
+    return board.GenValidMoves();
+}
+
+void DfpnSolver::LookUpChild(Piece piece, const Board& board, uint32_t* phi, uint32_t* delta,
+                             uint32_t* work) const {
+    *work = 0;
+    if (IsTerminal(piece, board, phi, delta)) {
+        return;
+    }
+    const Entry* entry = Find(board.Hash());
+    if (entry == nullptr) {
+        *phi = 1;
+        *delta = 1;
+        return;
+    }
+    *phi = entry->phi;
+    *delta = entry->delta;
+    *work = entry->work;
+}
+
+const DfpnSolver::Entry* DfpnSolver::Find(uint64_t key) const {
+    int bucket = static_cast<int>(key % (table.size() / kBucketSize)) * kBucketSize;
+    for (int i = bucket; i < bucket + kBucketSize; ++i) {
+        if (IsInUse(table[i]) && table[i].key == key) {
+            return &table[i];
+        }
+    }
+    return nullptr;
+}
+
+void DfpnSolver::Store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work) {
+    // Overwrite the same position, else an empty slot, else the entry with the
+    // least work behind it.
+    int bucket = static_cast<int>(key % (table.size() / kBucketSize)) * kBucketSize;
+    int victim = bucket;
+    for (int i = bucket; i < bucket + kBucketSize; ++i) {
+        if (IsInUse(table[i]) && table[i].key == key) {
+            victim = i;
+            break;
+        }
+        uint32_t work_i = IsInUse(table[i]) ? table[i].work : 0;
+        uint32_t work_victim = IsInUse(table[victim]) ? table[victim].work : 0;
+        if (work_i < work_victim) {
+            victim = i;
+        }
+    }
+    if (!IsInUse(table[victim])) {
+        ++num_entries;
+        peak_entries = std::max(peak_entries, num_entries);
+    }
+    table[victim].key = key;
+    table[victim].phi = phi;
+    table[victim].delta = delta;
+    table[victim].work = std::max<uint32_t>(work, 1);
+    table[victim].generation = generation;
+}
+
+bool DfpnSolver::IsInUse(const Entry& entry) const {
+    return entry.work != 0 && entry.generation == generation;
+}
+
+uint64_t DfpnSolver::CountProofTree(Piece piece, Board& board, bool is_proven,
+                                   std::unordered_set<uint64_t>& visited) {
+    if (visited.size() >= kMaxProofTreePositions) {
+        is_aborted = true;
+    }
+    if (is_aborted || visited.count(board.Hash()) != 0) {
+        return 0;
+    }
+    visited.insert(board.Hash());
+    uint32_t phi, delta;
+    if (IsTerminal(piece, board, &phi, &delta)) {
+        return 1;
+    }
+    Piece opposite_piece = Opposite(piece);
+    uint64_t size = 1;
+    if (is_proven) {
+        // One move reaching the goal is enough.
+        Move move;
+        if (!FindProvingMove(piece, board, &move)) {
+            return 0;
+        }
+        board.MakeMove(move, piece);
+        size += CountProofTree(opposite_piece, board, false, visited);
+        board.UnmakeMove(move);
+    } else {
+        // Every move has to be refuted.
+        for (const Move& move : GenMoves(piece, board)) {
+            board.MakeMove(move, piece);
+            size += CountProofTree(opposite_piece, board, true, visited);
+            board.UnmakeMove(move);
+        }
+    }
+    return size;
+}
+
+bool DfpnSolver::FindProvingMove(Piece piece, Board& board, Move* proving_move) {
+    Piece opposite_piece = Opposite(piece);
+    while (true) {
+        for (const Move& move : GenMoves(piece, board)) {
+            uint32_t phi, delta, work;
+            board.MakeMove(move, piece);
+            LookUpChild(opposite_piece, board, &phi, &delta, &work);
+            board.UnmakeMove(move);
+            if (delta == 0) {
+                *proving_move = move;
+                return true;
+            }
+        }
+        // The proving child was evicted from the table, prove it again.
+        uint32_t phi, delta;
+        Mid(piece, board, kDfpnInfinity, kDfpnInfinity, &phi, &delta);
+        if (is_aborted) {
+            return false;
+        }
+        assert(phi == 0);
+    }
+}
+
+void DfpnSolver::ClearTable() {
+    // Solve() clears the table twice per position, which would dominate the
+    // time of small solves if every entry were wiped. Only after the
+    // generation counter wraps around could a stale entry look current.
+    ++generation;
+    if (generation == 0) {
+        for (Entry& entry : table) {
+            entry.work = 0;
+        }
+        generation = 1;
+    }
+    num_entries = 0;
+}
+
+}
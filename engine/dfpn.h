@@ -0,0 +1,107 @@
+#ifndef DFPN_H
+#define DFPN_H
+
+#include "board.h"
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace ai {
+
+// Most positions DfpnSolver keeps track of while it counts a proof tree.
+constexpr uint64_t kMaxProofTreePositions = 1 << 20;
+
+enum class GameValue {
+    kWin,
+    kDraw,
+    kLoss,
+    kUnknown
+};
+
+// Game-theoretic value of a position for the side to move, as proven by
+// DfpnSolver::Solve().
+struct SolveResult {
+    SolveResult() : value(GameValue::kUnknown), nodes(0), proof_size(0), peak_entries(0),
+        peak_memory_bytes(0) {}
+    GameValue value;
+    // A winning move for kWin, a drawing move for kDraw, any move for kLoss.
+    Move best_move;
+    // Positions expanded by the search.
+    uint64_t nodes;
+    // Distinct positions in the proof (or disproof) tree of the result, or 0
+    // unless DfpnSolver::SetCountProofSize() asked for it and it fit the limits.
+    uint64_t proof_size;
+    // Most table entries in use at once, and the memory they take up.
+    uint64_t peak_entries;
+    uint64_t peak_memory_bytes;
+};
+
+// Depth-first proof-number search. Proves whether the side to move can force a
+// win and, if it cannot, whether the opponent can; a position where neither
+// can is a draw.
+//
+// Proof and disproof numbers live in a fixed-size table which replaces the
+// entries with the least work behind them when full, so memory use is bounded
+// by the size given to the constructor no matter how large the proof is.
+class DfpnSolver {
+public:
+    explicit DfpnSolver(int table_size_in_mb);
+    // Gives up with kUnknown after max_nodes expansions, 0 means no limit.
+    SolveResult Solve(SideToMove side, const Board& board, uint64_t max_nodes = 0);
+    // Whether Solve() walks the proof tree to fill SolveResult::proof_size. Off
+    // by default: the walk may search evicted positions again. It gets a budget
+    // of max_nodes of its own and gives up after kMaxProofTreePositions.
+    void SetCountProofSize(bool count);
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t phi;
+        uint32_t delta;
+        uint32_t work;
+        // Entries of an older generation are empty.
+        uint32_t generation;
+    };
+
+    // phi is the proof number of the goal of the side to move and delta the
+    // disproof number: the attacker's goal is to win, the defender's goal is
+    // not to lose.
+    void Mid(Piece piece, Board& board, uint32_t th_phi, uint32_t th_delta,
+             uint32_t* phi, uint32_t* delta);
+    // Positions decided without search: finished games, an immediate win for
+    // the side to move, a double threat against it, or no open line left for
+    // the attacker.
+    bool IsTerminal(Piece piece, const Board& board, uint32_t* phi, uint32_t* delta) const;
+    // The moves worth searching: only the winning move when there is one, and
+    // only the block when the opponent threatens to win on the next move.
+    std::vector<Move> GenMoves(Piece piece, const Board& board) const;
+    // phi and delta of the position after the last move, from the point of
+    // view of piece, the side to move in it.
+    void LookUpChild(Piece piece, const Board& board, uint32_t* phi, uint32_t* delta,
+                     uint32_t* work) const;
+    void Store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work);
+    const Entry* Find(uint64_t key) const;
+    // Counts the positions of the proof tree below a position whose side to
+    // move reaches its goal (phi == 0) or fails to (delta == 0). Positions
+    // evicted from the table are searched again. Sets is_aborted on reaching
+    // a limit.
+    uint64_t CountProofTree(Piece piece, Board& board, bool is_proven, std::unordered_set<uint64_t>& visited);
+    // Returns false if the search for an evicted proof was aborted.
+    bool FindProvingMove(Piece piece, Board& board, Move* move);
+    bool IsInUse(const Entry& entry) const;
+    // Empties the table in constant time by starting a new generation.
+    void ClearTable();
+
+    std::vector<Entry> table;
+    uint32_t generation;
+    Piece attacker;
+    uint64_t nodes;
+    uint64_t max_nodes;
+    bool is_aborted;
+    bool is_proof_size_counted;
+    uint64_t num_entries;
+    uint64_t peak_entries;
+};
+
+}
+
+#endif // DFPN_H
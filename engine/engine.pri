@@ -0,0 +1,16 @@
+# Links the engine library. Include it from a project of the same build tree
+# whose subdirs project builds engine.pro first.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+ENGINE_OUT = $$shadowed($$PWD)
+win32 {
+    CONFIG(debug, debug|release): ENGINE_OUT = $$ENGINE_OUT/debug
+    else: ENGINE_OUT = $$ENGINE_OUT/release
+}
+
+LIBS += -L$$ENGINE_OUT -lengine
+
+win32-msvc*: PRE_TARGETDEPS += $$ENGINE_OUT/engine.lib
+else: PRE_TARGETDEPS += $$ENGINE_OUT/libengine.a
@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# Game engine: boards, search, solver and caches. Plain C++11 without Qt, so
+# the headless tools and other front ends can link it.
+#
+#-------------------------------------------------
+
+TARGET = engine
+TEMPLATE = lib
+CONFIG += staticlib c++11 thread
+CONFIG -= qt
+
+SOURCES += \
+    board.cpp \
+    qubicboard.cpp \
+    ultimateboard.cpp \
+    ai.cpp \
+    dfpn.cpp \
+    transpositiontable.cpp \
+    persistentcache.cpp \
+    ntuple.cpp \
+    trace.cpp
+
+HEADERS += \
+    bitops.h \
+    board.h \
+    qubicboard.h \
+    ultimateboard.h \
+    ai.h \
+    dfpn.h \
+    transpositiontable.h \
+    persistentcache.h \
+    ntuple.h \
+    trace.h
@@ -0,0 +1,142 @@
+#include "ntuple.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+constexpr uint32_t kNTupleMagic = 0x4e545550; // "NTUP"
+constexpr uint32_t kNTupleVersion = 2;
+
+static_assert(sizeof(float) == sizeof(uint32_t), "weights are stored as 32-bit floats");
+
+namespace ntuple {
+
+namespace {
+
+std::atomic<const NTupleNetwork*> default_network(nullptr);
+
+// The file is little-endian whatever the byte order of the host.
+bool ReadUint32(std::istream& in, uint32_t* value) {
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+        return false;
+    }
+    *value = static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+            static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    return true;
+}
+
+void WriteUint32(std::ostream& out, uint32_t value) {
+    const char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8),
+                           static_cast<char>(value >> 16), static_cast<char>(value >> 24)};
+    out.write(bytes, sizeof(bytes));
+}
+
+}
+
+NTupleNetwork::NTupleNetwork(int num_rows_, int num_cols_, int win_length_) :
+    num_rows(num_rows_),
+    num_cols(num_cols_),
+    win_length(win_length_)
+{
+    Board board(num_rows, num_cols, win_length);
+    num_lines = board.NumLines();
+    num_line_patterns = board.NumLinePatterns();
+    weights.assign(num_lines * num_line_patterns, 0.0f);
+    fixed_weights.assign(weights.size(), 0);
+}
+
+bool NTupleNetwork::Matches(const Board& board) const {
+    return board.NumRows() == num_rows && board.NumCols() == num_cols &&
+            board.WinLength() == win_length;
+}
+
+float NTupleNetwork::Evaluate(const Board& board) const {
+    assert(Matches(board));
+    float value = 0.0f;
+    for (int line = 0; line < num_lines; ++line) {
+        value += weights[line * num_line_patterns + board.LineCode(line)];
+    }
+    return value;
+}
+
+void NTupleNetwork::Update(const Board& board, float delta) {
+    assert(Matches(board));
+    for (int line = 0; line < num_lines; ++line) {
+        int index = line * num_line_patterns + board.LineCode(line);
+        SetWeight(index, weights[index] + delta);
+    }
+}
+
+void NTupleNetwork::SetWeight(int index, float weight) {
+    weights[index] = weight;
+    double fixed = std::round(static_cast<double>(weight) * kFixedWeightOne);
+    fixed = std::max<double>(fixed, std::numeric_limits<int32_t>::min());
+    fixed = std::min<double>(fixed, std::numeric_limits<int32_t>::max());
+    fixed_weights[index] = static_cast<int32_t>(fixed);
+}
+
+int NTupleNetwork::NumWeights() const {
+    return static_cast<int>(weights.size());
+}
+
+bool NTupleNetwork::Load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    uint32_t magic, version, rows, cols, length;
+    if (!ReadUint32(in, &magic) || !ReadUint32(in, &version) || !ReadUint32(in, &rows) ||
+            !ReadUint32(in, &cols) || !ReadUint32(in, &length) ||
+            magic != kNTupleMagic || version != kNTupleVersion ||
+            rows == 0 || rows > kMaxBoardSize || cols == 0 || cols > kMaxBoardSize ||
+            length == 0 || length > kMaxWinLength || length > std::max(rows, cols)) {
+        return false;
+    }
+    NTupleNetwork loaded(static_cast<int>(rows), static_cast<int>(cols), static_cast<int>(length));
+    for (int index = 0; index < loaded.NumWeights(); ++index) {
+        uint32_t bits;
+        if (!ReadUint32(in, &bits)) {
+            return false;
+        }
+        float weight;
+        std::memcpy(&weight, &bits, sizeof(weight));
+        loaded.SetWeight(index, weight);
+    }
+    *this = loaded;
+    return true;
+}
+
+bool NTupleNetwork::Save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    WriteUint32(out, kNTupleMagic);
+    WriteUint32(out, kNTupleVersion);
+    WriteUint32(out, static_cast<uint32_t>(num_rows));
+    WriteUint32(out, static_cast<uint32_t>(num_cols));
+    WriteUint32(out, static_cast<uint32_t>(win_length));
+    for (float weight : weights) {
+        uint32_t bits;
+        std::memcpy(&bits, &weight, sizeof(bits));
+        WriteUint32(out, bits);
+    }
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+const NTupleNetwork* GetDefaultNetwork() {
+    return default_network.load(std::memory_order_acquire);
+}
+
+bool LoadDefaultNetwork(const std::string& path) {
+    NTupleNetwork* network = new NTupleNetwork();
+    if (!network->Load(path)) {
+        delete network;
+        return false;
+    }
+    // The previous network is leaked on purpose: a search running on another
+    // thread may still be reading it.
+    default_network.store(network, std::memory_order_release);
+    return true;
+}
+
+}
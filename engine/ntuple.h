@@ -0,0 +1,58 @@
+#ifndef NTUPLE_H
+#define NTUPLE_H
+
+#include "board.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ntuple {
+
+// Looked up next to the executable when the game starts.
+const char kDefaultWeightsFileName[] = "ntuple.weights";
+// FixedWeight() of a weight of 1.
+constexpr int32_t kFixedWeightOne = 1 << 16;
+
+// Pattern-table evaluation: every line of the board has its own table of
+// weights, one per line pattern, indexed by the line's pattern code. The value of a
+// position is the sum of one weight per line, from X's point of view, and is
+// trained towards +1 for a won game, -1 for a lost one and 0 for a draw.
+class NTupleNetwork {
+public:
+    NTupleNetwork(int num_rows = kNumRows, int num_cols = kNumCols, int win_length = kWinLength);
+    // Whether the network was made for boards of this size.
+    bool Matches(const Board& board) const;
+    float Evaluate(const Board& board) const;
+    // The weight of a line pattern in fixed point, which Board adds up exactly
+    // as moves are made and unmade.
+    int32_t FixedWeight(int line, int code) const {
+        return fixed_weights[line * num_line_patterns + code];
+    }
+    // Adds delta to every weight used by Evaluate(board).
+    void Update(const Board& board, float delta);
+    int NumWeights() const;
+    // Binary format: magic, version, board rows, columns and win length, and
+    // then the weights as little-endian 32-bit floats. The tuples are the
+    // lines of that board, so loading takes the board size of the file.
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+private:
+    int num_rows;
+    int num_cols;
+    int win_length;
+    int num_lines;
+    int num_line_patterns;
+    std::vector<float> weights;
+    std::vector<int32_t> fixed_weights;
+
+    void SetWeight(int index, float weight);
+};
+
+// The network new boards of its size evaluate with, see Board::SetNetwork().
+// Null until one has been loaded, for whatever board size the file was made.
+const NTupleNetwork* GetDefaultNetwork();
+bool LoadDefaultNetwork(const std::string& path);
+
+}
+
+#endif // NTUPLE_H
@@ -0,0 +1,352 @@
+#include "persistentcache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint64_t kCacheMagic = 0x4548434143545454ULL; // "TTTCACHE"
+constexpr uint32_t kCacheVersion = 1;
+constexpr int kCacheBucketSize = 4;
+
+struct PersistentCache::Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t num_rows;
+    uint32_t num_cols;
+    uint32_t win_length;
+    uint64_t num_slots;
+    uint64_t reserved[4];
+};
+
+struct PersistentCache::Slot {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "cache slots are shared through a file and must have a fixed layout");
+
+namespace {
+
+// Layout of the data word: score + 32768 in bits 0-15, depth in bits 16-23,
+// best move row in bits 24-31 and column in bits 32-39 (0xff for no move), and
+// bit 40 set for an occupied slot.
+constexpr uint64_t kOccupiedBit = 1ULL << 40;
+
+uint64_t Pack(const TranspositionEntry& entry) {
+    uint64_t row = (entry.best_move.row < 0) ? 0xff : static_cast<uint64_t>(entry.best_move.row);
+    uint64_t col = (entry.best_move.col < 0) ? 0xff : static_cast<uint64_t>(entry.best_move.col);
+    return static_cast<uint64_t>(static_cast<uint16_t>(entry.score + 32768)) |
+            static_cast<uint64_t>(std::min(entry.depth, kSolvedDepth) & 0xff) << 16 |
+            row << 24 | col << 32 | kOccupiedBit;
+}
+
+TranspositionEntry Unpack(uint64_t data) {
+    int row = static_cast<int>((data >> 24) & 0xff);
+    int col = static_cast<int>((data >> 32) & 0xff);
+    return TranspositionEntry(static_cast<int>(data & 0xffff) - 32768,
+                              static_cast<int>((data >> 16) & 0xff),
+                              (row == 0xff) ? Move() : Move(row, col));
+}
+
+}
+
+PersistentCache::PersistentCache() :
+#ifdef _WIN32
+    file(INVALID_HANDLE_VALUE),
+    file_mapping(nullptr),
+#else
+    file(-1),
+#endif
+    mapping(nullptr),
+    mapping_size(0),
+    slots(nullptr),
+    num_slots(0),
+    num_rows(0),
+    num_cols(0),
+    win_length(0)
+{
+
+}
+
+PersistentCache::~PersistentCache() {
+    Close();
+}
+
+namespace {
+
+#ifdef _WIN32
+
+bool ReadAt(HANDLE file, uint64_t offset, void* data, uint64_t size) {
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(offset);
+    DWORD num_read = 0;
+    return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) &&
+            ReadFile(file, data, static_cast<DWORD>(size), &num_read, nullptr) && num_read == size;
+}
+
+bool WriteAt(HANDLE file, uint64_t offset, const void* data, uint64_t size) {
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(offset);
+    DWORD num_written = 0;
+    return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) &&
+            WriteFile(file, data, static_cast<DWORD>(size), &num_written, nullptr) &&
+            num_written == size;
+}
+
+bool GetSize(HANDLE file, uint64_t* size) {
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        return false;
+    }
+    *size = static_cast<uint64_t>(file_size.QuadPart);
+    return true;
+}
+
+bool LockExclusive(HANDLE file) {
+    OVERLAPPED overlapped = {};
+    return LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);
+}
+
+void Unlock(HANDLE file) {
+    OVERLAPPED overlapped = {};
+    UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &overlapped);
+}
+
+// Truncates the file and then extends it with zeros.
+bool Resize(HANDLE file, uint64_t size) {
+    LARGE_INTEGER position;
+    position.QuadPart = 0;
+    if (!SetFilePointerEx(file, position, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+        return false;
+    }
+    position.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+}
+
+#else
+
+bool ReadAt(int file, uint64_t offset, void* data, uint64_t size) {
+    return pread(file, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+}
+
+bool WriteAt(int file, uint64_t offset, const void* data, uint64_t size) {
+    return pwrite(file, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+}
+
+bool GetSize(int file, uint64_t* size) {
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        return false;
+    }
+    *size = static_cast<uint64_t>(status.st_size);
+    return true;
+}
+
+bool LockExclusive(int file) {
+    int result;
+    do {
+        result = flock(file, LOCK_EX);
+    } while (result != 0 && errno == EINTR);
+    return result == 0;
+}
+
+void Unlock(int file) {
+    flock(file, LOCK_UN);
+}
+
+// Truncates the file and then extends it with zeros.
+bool Resize(int file, uint64_t size) {
+    return ftruncate(file, 0) == 0 && ftruncate(file, static_cast<off_t>(size)) == 0;
+}
+
+#endif
+
+}
+
+bool PersistentCache::Open(const std::string& path, int num_rows_, int num_cols_, int win_length_,
+                           int size_in_mb) {
+    Close();
+    uint64_t wanted_slots = std::max<uint64_t>(kCacheBucketSize,
+                                               (static_cast<uint64_t>(size_in_mb) << 20) / sizeof(Slot));
+    wanted_slots -= wanted_slots % kCacheBucketSize;
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+#else
+    file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        return false;
+    }
+#endif
+    if (!LockExclusive(file)) {
+        CloseFile();
+        return false;
+    }
+    bool is_mapped = InitializeAndMap(num_rows_, num_cols_, win_length_, wanted_slots);
+    Unlock(file);
+    if (!is_mapped) {
+        CloseFile();
+        return false;
+    }
+    return true;
+}
+
+bool PersistentCache::InitializeAndMap(int num_rows_, int num_cols_, int win_length_,
+                                       uint64_t wanted_slots) {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    uint64_t file_size = 0;
+    bool is_valid = GetSize(file, &file_size) && file_size >= sizeof(Header) &&
+            ReadAt(file, 0, &header, sizeof(header)) &&
+            header.magic == kCacheMagic && header.version == kCacheVersion &&
+            header.num_slots % kCacheBucketSize == 0 &&
+            file_size == sizeof(Header) + header.num_slots * sizeof(Slot);
+    if (is_valid && (static_cast<int>(header.num_rows) != num_rows_ ||
+                     static_cast<int>(header.num_cols) != num_cols_ ||
+                     static_cast<int>(header.win_length) != win_length_)) {
+        return false;
+    }
+    if (!is_valid) {
+        // New or unusable file: size it and write the header. The slots read
+        // as zero, i.e. empty. Every process maps the file only after it has
+        // checked it under the lock, so nobody has this one mapped.
+        std::memset(&header, 0, sizeof(header));
+        header.magic = kCacheMagic;
+        header.version = kCacheVersion;
+        header.num_rows = static_cast<uint32_t>(num_rows_);
+        header.num_cols = static_cast<uint32_t>(num_cols_);
+        header.win_length = static_cast<uint32_t>(win_length_);
+        header.num_slots = wanted_slots;
+        file_size = sizeof(Header) + wanted_slots * sizeof(Slot);
+        if (!Resize(file, file_size) || !WriteAt(file, 0, &header, sizeof(header))) {
+            return false;
+        }
+    }
+#ifdef _WIN32
+    file_mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    void* view = (file_mapping != nullptr) ?
+                MapViewOfFile(file_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+#else
+    void* view = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) {
+        view = nullptr;
+    }
+#endif
+    if (view == nullptr) {
+        return false;
+    }
+    mapping = static_cast<unsigned char*>(view);
+    mapping_size = file_size;
+    slots = reinterpret_cast<Slot*>(mapping + sizeof(Header));
+    num_slots = header.num_slots;
+    num_rows = num_rows_;
+    num_cols = num_cols_;
+    win_length = win_length_;
+    return true;
+}
+
+void PersistentCache::Close() {
+    if (mapping != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+#else
+        munmap(mapping, mapping_size);
+#endif
+    }
+    CloseFile();
+    mapping = nullptr;
+    mapping_size = 0;
+    slots = nullptr;
+    num_slots = 0;
+}
+
+void PersistentCache::CloseFile() {
+#ifdef _WIN32
+    if (file_mapping != nullptr) {
+        CloseHandle(file_mapping);
+        file_mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (file >= 0) {
+        close(file);
+        file = -1;
+    }
+#endif
+}
+
+bool PersistentCache::IsOpen() const {
+    return mapping != nullptr;
+}
+
+bool PersistentCache::Matches(const Board& board) const {
+    return IsOpen() && board.NumRows() == num_rows && board.NumCols() == num_cols &&
+            board.WinLength() == win_length;
+}
+
+bool PersistentCache::Probe(uint64_t key, int depth, TranspositionEntry* entry) const {
+    if (!IsOpen()) {
+        return false;
+    }
+    uint64_t bucket = key % (num_slots / kCacheBucketSize) * kCacheBucketSize;
+    for (uint64_t i = bucket; i < bucket + kCacheBucketSize; ++i) {
+        uint64_t data = slots[i].data.load(std::memory_order_acquire);
+        uint64_t check = slots[i].check.load(std::memory_order_relaxed);
+        if ((data & kOccupiedBit) == 0 || (check ^ data) != key) {
+            continue;
+        }
+        TranspositionEntry stored = Unpack(data);
+        if (stored.depth < depth) {
+            return false;
+        }
+        *entry = stored;
+        return true;
+    }
+    return false;
+}
+
+void PersistentCache::Store(uint64_t key, const TranspositionEntry& entry) {
+    if (!IsOpen()) {
+        return;
+    }
+    // Overwrite the same position unless it was searched deeper, else the
+    // shallowest entry of the bucket.
+    uint64_t bucket = key % (num_slots / kCacheBucketSize) * kCacheBucketSize;
+    uint64_t victim = bucket;
+    int victim_depth = kSolvedDepth + 1;
+    for (uint64_t i = bucket; i < bucket + kCacheBucketSize; ++i) {
+        uint64_t data = slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = slots[i].check.load(std::memory_order_relaxed);
+        int depth = (data & kOccupiedBit) ? Unpack(data).depth : -1;
+        if ((data & kOccupiedBit) != 0 && (check ^ data) == key) {
+            if (depth > entry.depth) {
+                return;
+            }
+            victim = i;
+            break;
+        }
+        if (depth < victim_depth) {
+            victim = i;
+            victim_depth = depth;
+        }
+    }
+    uint64_t data = Pack(entry);
+    slots[victim].check.store(key ^ data, std::memory_order_relaxed);
+    slots[victim].data.store(data, std::memory_order_release);
+}
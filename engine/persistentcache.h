@@ -0,0 +1,63 @@
+#ifndef PERSISTENTCACHE_H
+#define PERSISTENTCACHE_H
+
+#include "board.h"
+#include "transpositiontable.h"
+#include <cstdint>
+#include <string>
+
+// Depth recorded for positions whose value has been proven, e.g. by the
+// proof-number solver. Such entries satisfy a probe at any depth.
+constexpr int kSolvedDepth = 255;
+
+// A fixed-size position cache in a memory-mapped file, so search results
+// survive the process and can be shared by all processes on the host which map
+// the same file. The file is mapped with mmap(), or with a file mapping
+// object on Windows.
+//
+// Open() checks and initializes the file under an exclusive file lock, so
+// processes opening it at the same time see either a new file or a complete
+// one, and a file in use is never resized.
+//
+// There are no locks after that: every slot holds the packed entry and the entry xor'ed
+// with the position key, written with two atomic stores. A probe which reads a
+// slot while another thread or process is writing it sees a key mismatch and
+// treats it as a miss, so entries are never torn, only lost.
+class PersistentCache {
+public:
+    PersistentCache();
+    ~PersistentCache();
+    // Maps the file, creating it if needed. A file made for another board size
+    // is left alone and false is returned.
+    bool Open(const std::string& path, int num_rows, int num_cols, int win_length, int size_in_mb);
+    void Close();
+    bool IsOpen() const;
+    bool Matches(const Board& board) const;
+    bool Probe(uint64_t key, int depth, TranspositionEntry* entry) const;
+    void Store(uint64_t key, const TranspositionEntry& entry);
+private:
+    struct Header;
+    struct Slot;
+
+    // Checks the file, initializes it if it is new or unusable, and maps it.
+    // The caller holds the file lock.
+    bool InitializeAndMap(int num_rows_, int num_cols_, int win_length_, uint64_t wanted_slots);
+    // Closes the file handle, and with it the file, unless it is mapped.
+    void CloseFile();
+
+#ifdef _WIN32
+    void* file;
+    void* file_mapping;
+#else
+    int file;
+#endif
+    unsigned char* mapping;
+    uint64_t mapping_size;
+    Slot* slots;
+    uint64_t num_slots;
+    int num_rows;
+    int num_cols;
+    int win_length;
+};
+
+#endif // PERSISTENTCACHE_H
@@ -0,0 +1,274 @@
+#include "qubicboard.h"
+#include "bitops.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+
+namespace {
+
+constexpr uint64_t kAllSquares = ~0ULL;
+// The corners and the 8 inner squares lie on the most lines: their row,
+// column and pillar, a diagonal in each of the three planes through them and
+// a space diagonal.
+constexpr int kMaxSquareLines = 7;
+
+// Line masks and Zobrist keys, shared by all Qubic boards.
+struct QubicGeometry {
+    QubicGeometry();
+    uint64_t line_masks[kQubicNumLines];
+    uint64_t square_line_masks[kQubicNumSquares][kMaxSquareLines];
+    int num_square_lines[kQubicNumSquares];
+    uint64_t x_keys[kQubicNumSquares];
+    uint64_t o_keys[kQubicNumSquares];
+};
+
+int SquareOf(int layer, int row, int col) {
+    return (layer * kQubicSize + row) * kQubicSize + col;
+}
+
+QubicGeometry::QubicGeometry() :
+    num_square_lines()
+{
+    // The 13 directions whose first non-zero coordinate is positive. Every
+    // line is generated once, from the end it is walked away from.
+    int num_lines = 0;
+    for (int d_layer = -1; d_layer <= 1; ++d_layer) {
+        for (int d_row = -1; d_row <= 1; ++d_row) {
+            for (int d_col = -1; d_col <= 1; ++d_col) {
+                int first = (d_layer != 0) ? d_layer : (d_row != 0) ? d_row : d_col;
+                if (first <= 0) {
+                    continue;
+                }
+                for (int square = 0; square < kQubicNumSquares; ++square) {
+                    int layer = square / (kQubicSize * kQubicSize);
+                    int row = square / kQubicSize % kQubicSize;
+                    int col = square % kQubicSize;
+                    int last_layer = layer + (kQubicSize - 1) * d_layer;
+                    int last_row = row + (kQubicSize - 1) * d_row;
+                    int last_col = col + (kQubicSize - 1) * d_col;
+                    if (last_layer < 0 || last_layer >= kQubicSize || last_row < 0 ||
+                            last_row >= kQubicSize || last_col < 0 || last_col >= kQubicSize) {
+                        continue;
+                    }
+                    uint64_t mask = 0;
+                    for (int i = 0; i < kQubicSize; ++i) {
+                        mask |= 1ULL << SquareOf(layer + i * d_layer, row + i * d_row,
+                                                 col + i * d_col);
+                    }
+                    assert(num_lines < kQubicNumLines);
+                    line_masks[num_lines++] = mask;
+                }
+            }
+        }
+    }
+    assert(num_lines == kQubicNumLines);
+    for (int line = 0; line < kQubicNumLines; ++line) {
+        for (int square = 0; square < kQubicNumSquares; ++square) {
+            if (line_masks[line] & (1ULL << square)) {
+                assert(num_square_lines[square] < kMaxSquareLines);
+                square_line_masks[square][num_square_lines[square]++] = line_masks[line];
+            }
+        }
+    }
+    std::mt19937_64 gen(kZobristSeed);
+    for (int square = 0; square < kQubicNumSquares; ++square) {
+        x_keys[square] = gen();
+        o_keys[square] = gen();
+    }
+}
+
+const QubicGeometry& GetGeometry() {
+    static const QubicGeometry geometry;
+    return geometry;
+}
+
+int SquareOf(const Move& move) {
+    assert(move.row >= 0 && move.row < kQubicSize * kQubicSize &&
+           move.col >= 0 && move.col < kQubicSize);
+    return move.row * kQubicSize + move.col;
+}
+
+}
+
+QubicBoard::QubicBoard() :
+    x_bits(0),
+    o_bits(0),
+    hash(0),
+    is_x_won(false),
+    is_o_won(false)
+{
+
+}
+
+void QubicBoard::Reset() {
+    x_bits = 0;
+    o_bits = 0;
+    hash = 0;
+    is_x_won = false;
+    is_o_won = false;
+}
+
+void QubicBoard::PrintToConsole() const {
+    for (int row = 0; row < NumRows(); ++row) {
+        std::string curr_row;
+        for (int col = 0; col < NumCols(); ++col) {
+            Piece piece = At(row, col);
+            curr_row += (piece == Piece::X) ? 'X' : (piece == Piece::O) ? 'O' : '_';
+        }
+        std::cout << curr_row << std::endl;
+        if (row % kQubicSize == kQubicSize - 1) {
+            std::cout << std::endl;
+        }
+    }
+}
+
+std::string QubicBoard::ToString() const {
+    std::string text;
+    for (int square = 0; square < kQubicNumSquares; ++square) {
+        uint64_t bit = 1ULL << square;
+        text += (x_bits & bit) ? 'x' : (o_bits & bit) ? 'o' : '.';
+    }
+    return text;
+}
+
+bool QubicBoard::FromString(const std::string& text) {
+    Reset();
+    if (static_cast<int>(text.size()) != kQubicNumSquares) {
+        return false;
+    }
+    for (int square = 0; square < kQubicNumSquares; ++square) {
+        Move move(square / kQubicSize, square % kQubicSize);
+        if (text[square] == 'x' || text[square] == 'X') {
+            MakeMove(move, Piece::X);
+        } else if (text[square] == 'o' || text[square] == 'O') {
+            MakeMove(move, Piece::O);
+        } else if (text[square] != '.') {
+            Reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QubicBoard::CheckWin(const Piece& piece) const {
+    assert(piece != Piece::NoPiece);
+    return piece == Piece::X ? is_x_won : is_o_won;
+}
+
+bool QubicBoard::CheckDraw() const {
+    return (x_bits | o_bits) == kAllSquares;
+}
+
+Piece QubicBoard::At(int row, int col) const {
+    uint64_t bit = 1ULL << SquareOf(Move(row, col));
+    return (x_bits & bit) ? Piece::X : (o_bits & bit) ? Piece::O : Piece::NoPiece;
+}
+
+std::vector<Move> QubicBoard::GenValidMoves() const {
+    std::vector<Move> valid_moves;
+    uint64_t empty = ~(x_bits | o_bits);
+    valid_moves.reserve(PopCount(empty));
+    for (; empty != 0; empty &= empty - 1) {
+        int square = CountTrailingZeros(empty);
+        valid_moves.push_back(Move(square / kQubicSize, square % kQubicSize));
+    }
+    return valid_moves;
+}
+
+int QubicBoard::EvalBoard(Piece piece) const {
+    if (CheckWin(piece)) {
+        return kWinEval;
+    }
+    if (CheckDraw()) {
+        return kDrawEval;
+    }
+    // The search rarely reaches the end of a Qubic game, so unfinished
+    // positions are scored like on Board: by the squared piece counts of the
+    // lines each side can still complete.
+    int eval = 0;
+    for (uint64_t mask : GetGeometry().line_masks) {
+        int x_count = PopCount(x_bits & mask);
+        int o_count = PopCount(o_bits & mask);
+        if (o_count == 0) {
+            eval += x_count * x_count;
+        }
+        if (x_count == 0) {
+            eval -= o_count * o_count;
+        }
+    }
+    eval = std::max(-kWinEval + 1, std::min(kWinEval - 1, eval));
+    return piece == Piece::X ? eval : -eval;
+}
+
+bool QubicBoard::IsTerminalNode() const {
+    return is_x_won || is_o_won || CheckDraw();
+}
+
+void QubicBoard::MakeMove(const Move& move, Piece piece) {
+    int square = SquareOf(move);
+    uint64_t bit = 1ULL << square;
+    assert(((x_bits | o_bits) & bit) == 0 && piece != Piece::NoPiece);
+    const QubicGeometry& geometry = GetGeometry();
+    uint64_t& bits = (piece == Piece::X) ? x_bits : o_bits;
+    bits |= bit;
+    hash ^= (piece == Piece::X) ? geometry.x_keys[square] : geometry.o_keys[square];
+    // Only the lines through the new piece can have been completed.
+    bool is_won = false;
+    for (int i = 0; i < geometry.num_square_lines[square]; ++i) {
+        uint64_t mask = geometry.square_line_masks[square][i];
+        is_won |= (bits & mask) == mask;
+    }
+    (piece == Piece::X ? is_x_won : is_o_won) |= is_won;
+}
+
+void QubicBoard::UnmakeMove(const Move& move) {
+    int square = SquareOf(move);
+    uint64_t bit = 1ULL << square;
+    Piece piece = (x_bits & bit) ? Piece::X : (o_bits & bit) ? Piece::O : Piece::NoPiece;
+    assert(piece != Piece::NoPiece);
+    const QubicGeometry& geometry = GetGeometry();
+    (piece == Piece::X ? x_bits : o_bits) &= ~bit;
+    hash ^= (piece == Piece::X) ? geometry.x_keys[square] : geometry.o_keys[square];
+    // No move is made after a win, so the position before the last move was
+    // not won by anybody.
+    is_x_won = false;
+    is_o_won = false;
+}
+
+uint64_t QubicBoard::Hash() const {
+    return hash;
+}
+
+int QubicBoard::NumRows() const {
+    return kQubicSize * kQubicSize;
+}
+
+int QubicBoard::NumCols() const {
+    return kQubicSize;
+}
+
+int QubicBoard::NumSquares() const {
+    return kQubicNumSquares;
+}
+
+int QubicBoard::NumPieces() const {
+    return PopCount(x_bits | o_bits);
+}
+
+int QubicBoard::WinLength() const {
+    return kQubicSize;
+}
+
+int QubicBoard::NumLines() const {
+    return kQubicNumLines;
+}
+
+uint64_t QubicBoard::GetBits(Piece piece) const {
+    assert(piece != Piece::NoPiece);
+    return piece == Piece::X ? x_bits : o_bits;
+}
+
+const uint64_t* QubicBoard::GetLineMasks() {
+    return GetGeometry().line_masks;
+}
@@ -0,0 +1,53 @@
+#ifndef QUBICBOARD_H
+#define QUBICBOARD_H
+
+#include "board.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr int kQubicSize = 4;
+constexpr int kQubicNumSquares = kQubicSize * kQubicSize * kQubicSize;
+constexpr int kQubicNumLines = 76;
+
+// 3D tic-tac-toe on a 4x4x4 cube: a player wins by getting four pieces in a
+// row along any of the 76 lines of the cube.
+//
+// Square (layer, row, col) is bit layer * 16 + row * 4 + col of the 64-bit
+// bitboard of each side. Moves use the same contract as Board, with the four
+// layers stacked on top of each other: Move(layer * 4 + row, col), so the
+// cube looks like a 16 x 4 board to the engines and the UI.
+class QubicBoard {
+public:
+    QubicBoard();
+    void Reset();
+    void PrintToConsole() const;
+    std::string ToString() const;
+    bool FromString(const std::string& text);
+    bool CheckWin(const Piece& piece) const;
+    bool CheckDraw() const;
+    Piece At(int row, int col) const;
+    std::vector<Move> GenValidMoves() const;
+    int EvalBoard(Piece piece) const;
+    bool IsTerminalNode() const;
+    void MakeMove(const Move& move, Piece piece);
+    void UnmakeMove(const Move& move);
+    uint64_t Hash() const;
+    int NumRows() const;
+    int NumCols() const;
+    int NumSquares() const;
+    int NumPieces() const;
+    int WinLength() const;
+    int NumLines() const;
+    uint64_t GetBits(Piece piece) const;
+    // Masks of the 76 lines.
+    static const uint64_t* GetLineMasks();
+private:
+    uint64_t x_bits;
+    uint64_t o_bits;
+    uint64_t hash;
+    bool is_x_won;
+    bool is_o_won;
+};
+
+#endif // QUBICBOARD_H
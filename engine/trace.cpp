@@ -0,0 +1,137 @@
+#include "trace.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+constexpr int kRingBufferSize = 1 << 15;
+
+namespace trace {
+
+namespace internal {
+
+std::atomic<bool> is_enabled(false);
+
+}
+
+namespace {
+
+struct Event {
+    const char* category;
+    const char* name;
+    long long start_us;
+    long long duration_us;
+};
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(int tid_) : tid(tid_), next(0), events(kRingBufferSize) {}
+    int tid;
+    std::atomic<unsigned long long> next;
+    std::vector<Event> events;
+};
+
+// Buffers are registered once per thread and never freed, so spans recorded by
+// threads which have already exited can still be dumped.
+std::mutex& GetRegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<std::unique_ptr<ThreadBuffer>>& GetRegistry() {
+    static std::vector<std::unique_ptr<ThreadBuffer>> registry;
+    return registry;
+}
+
+ThreadBuffer* GetThreadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(GetRegistryMutex());
+        auto& registry = GetRegistry();
+        registry.emplace_back(new ThreadBuffer(static_cast<int>(registry.size()) + 1));
+        buffer = registry.back().get();
+    }
+    return buffer;
+}
+
+long long NowInUs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - epoch).count();
+}
+
+void WriteEscaped(std::ofstream& out, const char* str) {
+    for (; *str != '\0'; ++str) {
+        if (*str == '"' || *str == '\\') {
+            out << '\\';
+        }
+        out << *str;
+    }
+}
+
+}
+
+void SetEnabled(bool enabled) {
+    if (enabled) {
+        // Pin the epoch before the first span is recorded.
+        NowInUs();
+    }
+    internal::is_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DumpToFile(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "{\"traceEvents\":[";
+    bool is_first = true;
+    std::lock_guard<std::mutex> lock(GetRegistryMutex());
+    for (const auto& buffer : GetRegistry()) {
+        // Spans recorded while dumping may be torn; dump with tracing off or
+        // accept a few garbled events at the end of a busy buffer.
+        unsigned long long end = buffer->next.load(std::memory_order_acquire);
+        unsigned long long begin = end > kRingBufferSize ? end - kRingBufferSize : 0;
+        for (unsigned long long i = begin; i < end; ++i) {
+            const Event& event = buffer->events[i % kRingBufferSize];
+            out << (is_first ? "\n" : ",\n");
+            is_first = false;
+            out << "{\"cat\":\"";
+            WriteEscaped(out, event.category);
+            out << "\",\"name\":\"";
+            WriteEscaped(out, event.name);
+            out << "\",\"ph\":\"X\",\"ts\":" << event.start_us
+                << ",\"dur\":" << event.duration_us
+                << ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+}
+
+namespace internal {
+
+long long BeginSpan() {
+    return NowInUs();
+}
+
+void EndSpan(const char* category, const char* name, long long start_us) {
+    // Tracing may have been turned off while the span was open.
+    if (!IsEnabled()) {
+        return;
+    }
+    long long duration_us = NowInUs() - start_us;
+    ThreadBuffer* buffer = GetThreadBuffer();
+    unsigned long long index = buffer->next.load(std::memory_order_relaxed);
+    Event& event = buffer->events[index % kRingBufferSize];
+    event.category = category;
+    event.name = name;
+    event.start_us = start_us;
+    event.duration_us = duration_us;
+    buffer->next.store(index + 1, std::memory_order_release);
+}
+
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <string>
+
+// Lightweight scoped tracing. Every thread records completed spans into its own
+// fixed-size ring buffer, so recording takes no locks; the oldest spans are
+// overwritten when a buffer is full. DumpToFile() writes everything recorded so
+// far in the Chrome trace-event format (load it in chrome://tracing or Perfetto).
+//
+// When tracing is disabled a span costs one relaxed atomic load and a branch:
+// the checks are inline and only an enabled span calls into trace.cpp.
+namespace trace {
+
+namespace internal {
+
+extern std::atomic<bool> is_enabled;
+long long BeginSpan();
+void EndSpan(const char* category, const char* name, long long start_us);
+
+}
+
+void SetEnabled(bool enabled);
+inline bool IsEnabled() {
+    return internal::is_enabled.load(std::memory_order_relaxed);
+}
+bool DumpToFile(const std::string& path);
+
+class ScopedSpan {
+public:
+    // category and name must be string literals, only the pointers are stored.
+    ScopedSpan(const char* category_, const char* name_) :
+        category(category_), name(name_), start_us(IsEnabled() ? internal::BeginSpan() : -1) {}
+    ~ScopedSpan() {
+        if (start_us >= 0) {
+            internal::EndSpan(category, name, start_us);
+        }
+    }
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+private:
+    const char* category;
+    const char* name;
+    long long start_us;
+};
+
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) \
+    trace::ScopedSpan TRACE_CONCAT(trace_span_, __LINE__)(category, name)
+
+#endif // TRACE_H
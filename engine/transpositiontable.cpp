@@ -0,0 +1,31 @@
+#include "transpositiontable.h"
+
+TranspositionTable::TranspositionTable()
+{
+
+}
+
+bool TranspositionTable::Probe(uint64_t key, int depth, TranspositionEntry* entry) const {
+    auto it = table.find(key);
+    if (it == table.end() || it->second.depth < depth) {
+        return false;
+    }
+    *entry = it->second;
+    return true;
+}
+
+void TranspositionTable::Store(uint64_t key, const TranspositionEntry& entry) {
+    TranspositionEntry& stored = table[key];
+    if (stored.depth > entry.depth) {
+        return;
+    }
+    stored = entry;
+}
+
+void TranspositionTable::Clear() {
+    table.clear();
+}
+
+int TranspositionTable::Size() const {
+    return static_cast<int>(table.size());
+}
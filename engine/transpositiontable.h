@@ -0,0 +1,30 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include "board.h"
+#include <cstdint>
+#include <unordered_map>
+
+// Score is stored from the point of view of the side to move in the position,
+// so an entry can be reused no matter which side the search is maximizing for.
+struct TranspositionEntry {
+    TranspositionEntry() : score(0), depth(-1) {}
+    TranspositionEntry(int score_, int depth_, const Move& best_move_) :
+        score(score_), depth(depth_), best_move(best_move_) {}
+    int score;
+    int depth;
+    Move best_move;
+};
+
+class TranspositionTable {
+public:
+    TranspositionTable();
+    bool Probe(uint64_t key, int depth, TranspositionEntry* entry) const;
+    void Store(uint64_t key, const TranspositionEntry& entry);
+    void Clear();
+    int Size() const;
+private:
+    std::unordered_map<uint64_t, TranspositionEntry> table;
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,296 @@
+#include "ultimateboard.h"
+#include "bitops.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr int kSubBoardMask = (1 << kUltimateNumSubBoards) - 1;
+constexpr int kSubBoardsPerWord = 6;
+// The meta-board follows sub-boards 6-8 in the second word.
+constexpr int kMetaBoardShift = (kUltimateNumSubBoards - kSubBoardsPerWord) * kUltimateNumSubBoards;
+// A line of won sub-boards is worth this many lines of pieces.
+constexpr int kMetaLineWeight = 9;
+
+// Win tables of the 3x3 boards and Zobrist keys, shared by all boards.
+struct UltimateTables {
+    UltimateTables();
+    // Masks of the lines of a 3x3 board.
+    std::vector<int> line_masks;
+    // Whether a 3x3 mask of one side's pieces contains a line.
+    bool is_won[1 << kUltimateNumSubBoards];
+    uint64_t x_keys[kUltimateNumSquares];
+    uint64_t o_keys[kUltimateNumSquares];
+    // Indexed by forced sub-board + 1.
+    uint64_t forced_keys[kUltimateNumSubBoards + 1];
+};
+
+UltimateTables::UltimateTables() {
+    // The lines of the classic board.
+    Board board(kUltimateSubBoardSize, kUltimateSubBoardSize, kUltimateSubBoardSize);
+    for (const auto& line : board.GetLines()) {
+        int mask = 0;
+        for (int square : line) {
+            mask |= 1 << square;
+        }
+        line_masks.push_back(mask);
+    }
+    for (int bits = 0; bits <= kSubBoardMask; ++bits) {
+        is_won[bits] = false;
+        for (int mask : line_masks) {
+            is_won[bits] = is_won[bits] || (bits & mask) == mask;
+        }
+    }
+    std::mt19937_64 gen(kZobristSeed);
+    for (int square = 0; square < kUltimateNumSquares; ++square) {
+        x_keys[square] = gen();
+        o_keys[square] = gen();
+    }
+    // The empty position has hash 0 like every other board, so "any sub-board"
+    // has no key.
+    forced_keys[0] = 0;
+    for (int sub_board = 0; sub_board < kUltimateNumSubBoards; ++sub_board) {
+        forced_keys[sub_board + 1] = gen();
+    }
+}
+
+const UltimateTables& GetTables() {
+    static const UltimateTables tables;
+    return tables;
+}
+
+int SideOf(Piece piece) {
+    assert(piece != Piece::NoPiece);
+    return piece == Piece::X ? 0 : 1;
+}
+
+int SubBoardOf(int row, int col) {
+    return row / kUltimateSubBoardSize * kUltimateSubBoardSize + col / kUltimateSubBoardSize;
+}
+
+int CellOf(int row, int col) {
+    return row % kUltimateSubBoardSize * kUltimateSubBoardSize + col % kUltimateSubBoardSize;
+}
+
+Move MoveOf(int sub_board, int cell) {
+    return Move(sub_board / kUltimateSubBoardSize * kUltimateSubBoardSize + cell / kUltimateSubBoardSize,
+                sub_board % kUltimateSubBoardSize * kUltimateSubBoardSize + cell % kUltimateSubBoardSize);
+}
+
+// Bit of a cell of a sub-board in the word holding the sub-board.
+uint64_t CellBit(int sub_board, int cell) {
+    return 1ULL << (sub_board % kSubBoardsPerWord * kUltimateNumSubBoards + cell);
+}
+
+// Squared piece counts of the lines of a 3x3 board each side can still
+// complete, from X's point of view. Lines through a blocked square count for
+// nobody.
+int EvalOpenLines(int x_bits, int o_bits, int blocked_bits) {
+    int eval = 0;
+    for (int mask : GetTables().line_masks) {
+        if (blocked_bits & mask) {
+            continue;
+        }
+        int x_count = PopCount(static_cast<uint64_t>(x_bits & mask));
+        int o_count = PopCount(static_cast<uint64_t>(o_bits & mask));
+        if (o_count == 0) {
+            eval += x_count * x_count;
+        }
+        if (x_count == 0) {
+            eval -= o_count * o_count;
+        }
+    }
+    return eval;
+}
+
+}
+
+UltimateBoard::UltimateBoard() :
+    bits(),
+    forced_sub_board(kNoForcedSubBoard),
+    hash(0),
+    num_pieces(0)
+{
+
+}
+
+void UltimateBoard::Reset() {
+    for (auto& side_bits : bits) {
+        side_bits[0] = side_bits[1] = 0;
+    }
+    forced_sub_board = kNoForcedSubBoard;
+    forced_history.clear();
+    hash = 0;
+    num_pieces = 0;
+}
+
+void UltimateBoard::PrintToConsole() const {
+    for (int row = 0; row < NumRows(); ++row) {
+        std::string curr_row;
+        for (int col = 0; col < NumCols(); ++col) {
+            Piece piece = At(row, col);
+            curr_row += (piece == Piece::X) ? 'X' : (piece == Piece::O) ? 'O' : '_';
+            if (col % kUltimateSubBoardSize == kUltimateSubBoardSize - 1) {
+                curr_row += ' ';
+            }
+        }
+        std::cout << curr_row << std::endl;
+    }
+}
+
+int UltimateBoard::SubBoardBits(int side, int sub_board) const {
+    return (bits[side][sub_board / kSubBoardsPerWord] >>
+            (sub_board % kSubBoardsPerWord * kUltimateNumSubBoards)) & kSubBoardMask;
+}
+
+int UltimateBoard::MetaBoardBits(int side) const {
+    return (bits[side][1] >> kMetaBoardShift) & kSubBoardMask;
+}
+
+int UltimateBoard::ClosedSubBoards() const {
+    int closed = MetaBoardBits(0) | MetaBoardBits(1);
+    for (int sub_board = 0; sub_board < kUltimateNumSubBoards; ++sub_board) {
+        if ((SubBoardBits(0, sub_board) | SubBoardBits(1, sub_board)) == kSubBoardMask) {
+            closed |= 1 << sub_board;
+        }
+    }
+    return closed;
+}
+
+bool UltimateBoard::CheckWin(const Piece& piece) const {
+    return GetTables().is_won[MetaBoardBits(SideOf(piece))];
+}
+
+bool UltimateBoard::CheckDraw() const {
+    return ClosedSubBoards() == kSubBoardMask && !CheckWin(Piece::X) && !CheckWin(Piece::O);
+}
+
+Piece UltimateBoard::At(int row, int col) const {
+    assert(row >= 0 && row < kUltimateSize && col >= 0 && col < kUltimateSize);
+    int sub_board = SubBoardOf(row, col);
+    int cell_bit = 1 << CellOf(row, col);
+    return (SubBoardBits(0, sub_board) & cell_bit) ? Piece::X :
+           (SubBoardBits(1, sub_board) & cell_bit) ? Piece::O : Piece::NoPiece;
+}
+
+std::vector<Move> UltimateBoard::GenValidMoves() const {
+    std::vector<Move> valid_moves;
+    // Only the forced sub-board is scanned. Otherwise every open sub-board is,
+    // but the closed ones are skipped as a whole.
+    int sub_boards = (forced_sub_board != kNoForcedSubBoard) ? 1 << forced_sub_board :
+                                                               ~ClosedSubBoards() & kSubBoardMask;
+    for (; sub_boards != 0; sub_boards &= sub_boards - 1) {
+        int sub_board = CountTrailingZeros(static_cast<uint64_t>(sub_boards));
+        int empty = ~(SubBoardBits(0, sub_board) | SubBoardBits(1, sub_board)) & kSubBoardMask;
+        for (; empty != 0; empty &= empty - 1) {
+            valid_moves.push_back(MoveOf(sub_board, CountTrailingZeros(static_cast<uint64_t>(empty))));
+        }
+    }
+    return valid_moves;
+}
+
+int UltimateBoard::EvalBoard(Piece piece) const {
+    if (CheckWin(piece)) {
+        return kWinEval;
+    }
+    if (CheckDraw()) {
+        return kDrawEval;
+    }
+    // Unfinished positions are scored by the open lines of the meta-board,
+    // where a drawn sub-board blocks both sides, and of every open sub-board.
+    int closed = ClosedSubBoards();
+    int x_meta = MetaBoardBits(0);
+    int o_meta = MetaBoardBits(1);
+    int drawn = closed & ~(x_meta | o_meta);
+    int eval = kMetaLineWeight * EvalOpenLines(x_meta, o_meta, drawn);
+    for (int sub_board = 0; sub_board < kUltimateNumSubBoards; ++sub_board) {
+        if ((closed & (1 << sub_board)) == 0) {
+            eval += EvalOpenLines(SubBoardBits(0, sub_board), SubBoardBits(1, sub_board), 0);
+        }
+    }
+    eval = std::max(-kWinEval + 1, std::min(kWinEval - 1, eval));
+    return piece == Piece::X ? eval : -eval;
+}
+
+bool UltimateBoard::IsTerminalNode() const {
+    return CheckWin(Piece::X) || CheckWin(Piece::O) || ClosedSubBoards() == kSubBoardMask;
+}
+
+void UltimateBoard::MakeMove(const Move& move, Piece piece) {
+    int sub_board = SubBoardOf(move.row, move.col);
+    int cell = CellOf(move.row, move.col);
+    assert(At(move.row, move.col) == Piece::NoPiece);
+    assert(forced_sub_board == kNoForcedSubBoard || forced_sub_board == sub_board);
+    assert(!IsSubBoardClosed(sub_board));
+    const UltimateTables& tables = GetTables();
+    int side = SideOf(piece);
+    bits[side][sub_board / kSubBoardsPerWord] |= CellBit(sub_board, cell);
+    if (tables.is_won[SubBoardBits(side, sub_board)]) {
+        bits[side][1] |= 1ULL << (kMetaBoardShift + sub_board);
+    }
+    int square = sub_board * kUltimateNumSubBoards + cell;
+    hash ^= (piece == Piece::X) ? tables.x_keys[square] : tables.o_keys[square];
+    forced_history.push_back(static_cast<int8_t>(forced_sub_board));
+    hash ^= tables.forced_keys[forced_sub_board + 1];
+    forced_sub_board = IsSubBoardClosed(cell) ? kNoForcedSubBoard : cell;
+    hash ^= tables.forced_keys[forced_sub_board + 1];
+    ++num_pieces;
+}
+
+void UltimateBoard::UnmakeMove(const Move& move) {
+    int sub_board = SubBoardOf(move.row, move.col);
+    int cell = CellOf(move.row, move.col);
+    Piece piece = At(move.row, move.col);
+    assert(piece != Piece::NoPiece && !forced_history.empty());
+    const UltimateTables& tables = GetTables();
+    int side = SideOf(piece);
+    bits[side][sub_board / kSubBoardsPerWord] &= ~CellBit(sub_board, cell);
+    // Nobody plays in a won sub-board, so if it is won, this move won it.
+    bits[side][1] &= ~(1ULL << (kMetaBoardShift + sub_board));
+    int square = sub_board * kUltimateNumSubBoards + cell;
+    hash ^= (piece == Piece::X) ? tables.x_keys[square] : tables.o_keys[square];
+    hash ^= tables.forced_keys[forced_sub_board + 1];
+    forced_sub_board = forced_history.back();
+    forced_history.pop_back();
+    hash ^= tables.forced_keys[forced_sub_board + 1];
+    --num_pieces;
+}
+
+uint64_t UltimateBoard::Hash() const {
+    return hash;
+}
+
+int UltimateBoard::NumRows() const {
+    return kUltimateSize;
+}
+
+int UltimateBoard::NumCols() const {
+    return kUltimateSize;
+}
+
+int UltimateBoard::NumSquares() const {
+    return kUltimateNumSquares;
+}
+
+int UltimateBoard::NumPieces() const {
+    return num_pieces;
+}
+
+int UltimateBoard::GetForcedSubBoard() const {
+    return forced_sub_board;
+}
+
+Piece UltimateBoard::GetSubBoardWinner(int sub_board) const {
+    assert(sub_board >= 0 && sub_board < kUltimateNumSubBoards);
+    return (MetaBoardBits(0) & (1 << sub_board)) ? Piece::X :
+           (MetaBoardBits(1) & (1 << sub_board)) ? Piece::O : Piece::NoPiece;
+}
+
+bool UltimateBoard::IsSubBoardClosed(int sub_board) const {
+    assert(sub_board >= 0 && sub_board < kUltimateNumSubBoards);
+    return GetSubBoardWinner(sub_board) != Piece::NoPiece ||
+           (SubBoardBits(0, sub_board) | SubBoardBits(1, sub_board)) == kSubBoardMask;
+}
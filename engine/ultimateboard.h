@@ -0,0 +1,62 @@
+#ifndef ULTIMATEBOARD_H
+#define ULTIMATEBOARD_H
+
+#include "board.h"
+#include <cstdint>
+#include <vector>
+
+constexpr int kUltimateSubBoardSize = 3;
+constexpr int kUltimateNumSubBoards = kUltimateSubBoardSize * kUltimateSubBoardSize;
+constexpr int kUltimateSize = kUltimateSubBoardSize * kUltimateSubBoardSize;
+constexpr int kUltimateNumSquares = kUltimateSize * kUltimateSize;
+// Any open sub-board may be played.
+constexpr int kNoForcedSubBoard = -1;
+
+// Ultimate tic-tac-toe: a 3x3 grid of classic boards. Winning a sub-board
+// claims its square of the meta-board, and the game is won on the meta-board.
+// The cell of a move picks the sub-board the opponent has to play in next,
+// unless that sub-board is closed (won or full), in which case the opponent
+// may play in any open sub-board.
+//
+// Moves use the same contract as Board on the 9x9 grid of all cells. For
+// each side the nine 9-bit sub-boards and the 9-bit meta-board are packed in
+// two 64-bit words: sub-boards 0-5 in the first word, sub-boards 6-8 and
+// the meta-board in the second.
+class UltimateBoard {
+public:
+    UltimateBoard();
+    void Reset();
+    void PrintToConsole() const;
+    bool CheckWin(const Piece& piece) const;
+    // No moves left and nobody has won the meta-board.
+    bool CheckDraw() const;
+    Piece At(int row, int col) const;
+    std::vector<Move> GenValidMoves() const;
+    int EvalBoard(Piece piece) const;
+    bool IsTerminalNode() const;
+    void MakeMove(const Move& move, Piece piece);
+    void UnmakeMove(const Move& move);
+    // Includes the forced sub-board, which is part of the position.
+    uint64_t Hash() const;
+    int NumRows() const;
+    int NumCols() const;
+    int NumSquares() const;
+    int NumPieces() const;
+    // Sub-board the side to move has to play in, or kNoForcedSubBoard.
+    int GetForcedSubBoard() const;
+    // Winner of a sub-board, Piece::NoPiece if it is still open or drawn.
+    Piece GetSubBoardWinner(int sub_board) const;
+    bool IsSubBoardClosed(int sub_board) const;
+private:
+    int SubBoardBits(int side, int sub_board) const;
+    int MetaBoardBits(int side) const;
+    int ClosedSubBoards() const;
+    uint64_t bits[2][2];
+    int forced_sub_board;
+    // Forced sub-boards before each move, restored by UnmakeMove().
+    std::vector<int8_t> forced_history;
+    uint64_t hash;
+    int num_pieces;
+};
+
+#endif // ULTIMATEBOARD_H
@@ -1,15 +1,15 @@
 #include "gamestate.h"
+#include "trace.h"
 #include <QDebug>
 
 GameState::GameState() :
+    variant(GameVariant::kClassic),
     side_to_move(SideToMove::X),
     is_finished(false),
     game_status(GameStatus::InProgress),
-    player_x(Player::Human),
-    player_o(Player::Computer),
-    player_to_move(Player::Human),
     computer_mode(ComputerMode::kPlaysO),
-    ai_algorithm(AiAlgorithm::kRandom)
+    ai_algorithm(AiAlgorithm::kRandom),
+    num_moves_played(0)
 {
 
 }
@@ -35,6 +35,7 @@ bool GameState::IsGameFinished() {
 }
 
 void GameState::UpdateGameStatus() {
+    TRACE_SCOPE("game", "GameState::UpdateGameStatus");
     if (CheckWin(SideToMove::X)) {
         game_status = GameStatus::XWon;
         is_finished = true;
@@ -49,34 +50,42 @@ void GameState::UpdateGameStatus() {
 
 bool GameState::CheckWin(const SideToMove& side) {
     Piece piece = side == SideToMove::X ? Piece::X : Piece::O;
-    for (int i = 0; i < kNumRows; ++i) {
-        if (board.CheckRowWin(i, piece) || board.CheckColWin(i, piece)) {
-            return true;
-        }
+    switch (variant) {
+    case GameVariant::kQubic:
+        return qubic_board.CheckWin(piece);
+    case GameVariant::kUltimate:
+        return ultimate_board.CheckWin(piece);
+    default:
+        return board.CheckWin(piece);
     }
-    return board.CheckMainDiagWin(piece) || board.CheckAntiDiagWin(piece);
 }
 
 bool GameState::CheckDraw() {
-    return board.CheckDraw();
+    switch (variant) {
+    case GameVariant::kQubic:
+        return qubic_board.CheckDraw();
+    case GameVariant::kUltimate:
+        return ultimate_board.CheckDraw();
+    default:
+        return board.CheckDraw();
+    }
 }
 
 void GameState::Reset() {
     board.Reset();
+    qubic_board.Reset();
+    ultimate_board.Reset();
     ResetSideToMove();
-    ResetPlayerToMove();
     ResetGameStatus();
     ResetIsFinished();
+    history.clear();
+    num_moves_played = 0;
 }
 
 void GameState::ResetSideToMove() {
     SetSideToMove(SideToMove::X);
 }
 
-void GameState::ResetPlayerToMove() {
-    SetPlayerToMove(GetPlayerX());
-}
-
 void GameState::ResetGameStatus() {
     SetGameStatus(GameStatus::InProgress);
 }
@@ -109,6 +118,89 @@ const Board& GameState::GetBoard() const {
     return board;
 }
 
+QubicBoard& GameState::GetQubicBoard() {
+    return qubic_board;
+}
+
+const QubicBoard& GameState::GetQubicBoard() const {
+    return qubic_board;
+}
+
+UltimateBoard& GameState::GetUltimateBoard() {
+    return ultimate_board;
+}
+
+const UltimateBoard& GameState::GetUltimateBoard() const {
+    return ultimate_board;
+}
+
+GameVariant GameState::GetVariant() const {
+    return variant;
+}
+
+void GameState::SetVariant(GameVariant variant_) {
+    variant = variant_;
+    Reset();
+}
+
+Piece GameState::PieceAt(int row, int col) const {
+    switch (variant) {
+    case GameVariant::kQubic:
+        return qubic_board.At(row, col);
+    case GameVariant::kUltimate:
+        return ultimate_board.At(row, col);
+    default:
+        return board.At(row, col);
+    }
+}
+
+int GameState::NumRows() const {
+    switch (variant) {
+    case GameVariant::kQubic:
+        return qubic_board.NumRows();
+    case GameVariant::kUltimate:
+        return ultimate_board.NumRows();
+    default:
+        return board.NumRows();
+    }
+}
+
+int GameState::NumCols() const {
+    switch (variant) {
+    case GameVariant::kQubic:
+        return qubic_board.NumCols();
+    case GameVariant::kUltimate:
+        return ultimate_board.NumCols();
+    default:
+        return board.NumCols();
+    }
+}
+
+quint64 GameState::GetPositionHash() const {
+    switch (variant) {
+    case GameVariant::kQubic:
+        return qubic_board.Hash();
+    case GameVariant::kUltimate:
+        return ultimate_board.Hash();
+    default:
+        return board.Hash();
+    }
+}
+
+bool GameState::IsValidMove(const Move& move) const {
+    if (PieceAt(move.row, move.col) != Piece::NoPiece) {
+        return false;
+    }
+    if (variant != GameVariant::kUltimate) {
+        return true;
+    }
+    int sub_board = move.row / kUltimateSubBoardSize * kUltimateSubBoardSize +
+                    move.col / kUltimateSubBoardSize;
+    int forced_sub_board = ultimate_board.GetForcedSubBoard();
+    return !ultimate_board.IsSubBoardClosed(sub_board) &&
+           (forced_sub_board == kNoForcedSubBoard || forced_sub_board == sub_board);
+}
+
 const Piece GameState::GetPieceToMove() const {
     return GetSideToMove() == SideToMove::X ? Piece::X : Piece::O;
 }
@@ -127,37 +219,100 @@ QString GameState::GetGameOutcomeText() const {
 }
 
 Player GameState::GetPlayerToMove() const {
-    return player_to_move;
+    return GetSideToMove() == SideToMove::X ? GetPlayerX() : GetPlayerO();
 }
 
-void GameState::SetPlayerToMove(Player player) {
-    player_to_move = player;
+void GameState::MakeMove(const Move& move) {
+    TRACE_SCOPE("game", "GameState::MakeMove");
+    history.resize(num_moves_played);
+    history.append(move);
+    ++num_moves_played;
+    PlayMove(move);
 }
 
-void GameState::SwitchPlayerToMove() {
-    SetPlayerToMove(GetPlayerToMove() == Player::Computer ? Player::Human : Player::Computer);
+bool GameState::UndoMove() {
+    if (!CanUndo()) {
+        return false;
+    }
+    Move move = history[--num_moves_played];
+    switch (variant) {
+    case GameVariant::kQubic:
+        GetQubicBoard().UnmakeMove(move);
+        break;
+    case GameVariant::kUltimate:
+        GetUltimateBoard().UnmakeMove(move);
+        break;
+    default:
+        GetBoard().UnmakeMove(move);
+    }
+    SwitchSideToMove();
+    // The game went on after every move but the last.
+    ResetGameStatus();
+    ResetIsFinished();
+    return true;
 }
 
-void GameState::MakeMove(const Move& move) {
-    GetBoard().At(move.row, move.col) = GetPieceToMove();
-    SwitchSideToMove();
-    UpdateGameStatus();
+bool GameState::RedoMove() {
+    if (!CanRedo()) {
+        return false;
+    }
+    PlayMove(history[num_moves_played++]);
+    return true;
 }
 
-Player GameState::GetPlayerX() const {
-    return player_x;
+bool GameState::UndoTurn() {
+    if (!UndoMove()) {
+        return false;
+    }
+    while (GetPlayerToMove() == Player::Computer && UndoMove()) {
+    }
+    return true;
+}
+
+bool GameState::RedoTurn() {
+    if (!RedoMove()) {
+        return false;
+    }
+    while (GetPlayerToMove() == Player::Computer && RedoMove()) {
+    }
+    return true;
 }
 
-void GameState::SetPlayerX(Player player) {
-    player_x = player;
+bool GameState::CanUndo() const {
+    return num_moves_played > 0;
 }
 
-Player GameState::GetPlayerO() const {
-    return player_o;
+bool GameState::CanRedo() const {
+    return num_moves_played < history.size();
 }
 
-void GameState::SetPlayerO(Player player) {
-    player_o = player;
+QVector<Move> GameState::GetMoveHistory() const {
+    return history.mid(0, num_moves_played);
+}
+
+void GameState::PlayMove(const Move& move) {
+    switch (variant) {
+    case GameVariant::kQubic:
+        GetQubicBoard().MakeMove(move, GetPieceToMove());
+        break;
+    case GameVariant::kUltimate:
+        GetUltimateBoard().MakeMove(move, GetPieceToMove());
+        break;
+    default:
+        GetBoard().MakeMove(move, GetPieceToMove());
+    }
+    SwitchSideToMove();
+    UpdateGameStatus();
+}
+
+Player GameState::GetPlayerX() const {
+    return computer_mode == ComputerMode::kPlaysX || computer_mode == ComputerMode::kPlaysBoth ?
+                Player::Computer : Player::Human;
+}
+
+Player GameState::GetPlayerO() const {
+    return computer_mode == ComputerMode::kPlaysO || computer_mode == ComputerMode::kPlaysBoth ?
+                Player::Computer : Player::Human;
 }
 
 ComputerMode GameState::GetComputerMode() const {
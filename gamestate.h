@@ -2,14 +2,12 @@
 #define GAMESTATE_H
 
 #include "board.h"
+#include "qubicboard.h"
+#include "ultimateboard.h"
+#include "ai.h"
 #include <QVector>
 #include <QRect>
 
-enum class SideToMove {
-    X,
-    O
-};
-
 enum class GameStatus {
     InProgress,
     XWon,
@@ -29,9 +27,10 @@ enum class ComputerMode {
     kPlaysBoth,
 };
 
-enum class AiAlgorithm {
-    kRandom,
-    kMinimax
+enum class GameVariant {
+    kClassic,
+    kQubic,
+    kUltimate
 };
 
 class GameState
@@ -41,7 +40,6 @@ public:
     void Reset();
     void ResetBoard();
     void ResetSideToMove();
-    void ResetPlayerToMove();
     void ResetGameStatus();
     void ResetIsFinished();
 
@@ -64,34 +62,66 @@ public:
     void UpdateGameStatus();
     Board& GetBoard();
     const Board& GetBoard() const;
+    QubicBoard& GetQubicBoard();
+    const QubicBoard& GetQubicBoard() const;
+    UltimateBoard& GetUltimateBoard();
+    const UltimateBoard& GetUltimateBoard() const;
+    GameVariant GetVariant() const;
+    // Switches to the other game and starts it from the empty board.
+    void SetVariant(GameVariant variant_);
+    // Queries about the board of the current variant. Qubic is laid out as
+    // its four layers stacked on top of each other, Ultimate as a 9x9 grid.
+    Piece PieceAt(int row, int col) const;
+    int NumRows() const;
+    int NumCols() const;
+    quint64 GetPositionHash() const;
+    // Whether the side to move may play move: the square is empty and, in
+    // Ultimate, it lies in a sub-board that may be played.
+    bool IsValidMove(const Move& move) const;
     const Piece GetPieceToMove() const;
+    // Who plays each side follows from the computer mode, so the player to
+    // move is always that of the side to move.
     Player GetPlayerToMove() const;
-    void SetPlayerToMove(Player player);
-    void SwitchPlayerToMove();
     Player GetPlayerX() const;
-    void SetPlayerX(Player player);
     Player GetPlayerO() const;
-    void SetPlayerO(Player player);
     ComputerMode GetComputerMode() const;
     void SetComputerMode(ComputerMode mode);
     AiAlgorithm GetAiAlgorithm() const;
     void SetAiAlgorithm(AiAlgorithm algorithm);
 
+    // Plays move and forgets the moves that could be redone.
     void MakeMove(const Move& move);
+    // Take back the last move and play it again. Both return false when there
+    // is no such move.
+    bool UndoMove();
+    bool RedoMove();
+    // Take back or play again moves until a human is to move, so that the
+    // reply of the computer goes together with the move it answered.
+    bool UndoTurn();
+    bool RedoTurn();
+    bool CanUndo() const;
+    bool CanRedo() const;
+    // Moves played since the start of the game.
+    QVector<Move> GetMoveHistory() const;
 
     QString GetGameOutcomeText() const;
 protected:
     //
 private:
+    GameVariant variant;
     Board board;
+    QubicBoard qubic_board;
+    UltimateBoard ultimate_board;
     SideToMove side_to_move;
     bool is_finished;
     GameStatus game_status;
-    Player player_x;
-    Player player_o;
-    Player player_to_move;
     ComputerMode computer_mode;
     AiAlgorithm ai_algorithm;
+    // Every move of the game, the undone ones after the first num_moves_played.
+    QVector<Move> history;
+    int num_moves_played;
+
+    void PlayMove(const Move& move);
 };
 
 #endif // GAMESTATE_H
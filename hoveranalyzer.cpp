@@ -0,0 +1,89 @@
+#include "hoveranalyzer.h"
+#include "trace.h"
+#include <QtConcurrent>
+
+namespace ai {
+
+HoverAnalyzer::HoverAnalyzer() :
+    num_runs(0)
+{
+
+}
+
+HoverAnalyzer::~HoverAnalyzer() {
+    // The runs use this object until they return.
+    Stop();
+    std::unique_lock<std::mutex> lock(mutex);
+    runs_finished.wait(lock, [this]() { return num_runs == 0; });
+}
+
+void HoverAnalyzer::Start(SideToMove side, const Board& board, int depth,
+                          const std::function<void()>& on_finished) {
+    Stop();
+    stop = std::make_shared<std::atomic<bool>>(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++num_runs;
+    }
+    std::shared_ptr<std::atomic<bool>> run_stop = stop;
+    QtConcurrent::run([this, run_stop, side, board, depth, on_finished]() {
+        Run(run_stop, side, board, depth, on_finished);
+    });
+}
+
+void HoverAnalyzer::Stop() {
+    if (stop) {
+        *stop = true;
+    }
+}
+
+bool HoverAnalyzer::Probe(quint64 child_key, int* score) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!child_scores.contains(child_key)) {
+        return false;
+    }
+    *score = child_scores.value(child_key);
+    return true;
+}
+
+bool HoverAnalyzer::IsRunning() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_runs > 0;
+}
+
+void HoverAnalyzer::Run(std::shared_ptr<std::atomic<bool>> run_stop, SideToMove side, Board board,
+                        int depth, std::function<void()> on_finished) {
+    if (Analyze(*run_stop, side, board, depth) && on_finished) {
+        on_finished();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    --num_runs;
+    runs_finished.notify_all();
+}
+
+bool HoverAnalyzer::Analyze(const std::atomic<bool>& run_stop, SideToMove side, Board board,
+                            int depth) {
+    TRACE_SCOPE("engine", "ai::HoverAnalyzer::Analyze");
+    // A superseded run still searching sees its stop flag soon.
+    std::lock_guard<std::mutex> table_lock(table_mutex);
+    if (run_stop) {
+        return false;
+    }
+    SearchContext context;
+    context.table = &table;
+    context.stop = &run_stop;
+    std::vector<RootMoveScore> scores = AnalyzeRoot(side, board, depth, &context);
+    if (context.IsStopped()) {
+        return false;
+    }
+    Piece piece = (side == SideToMove::X) ? Piece::X : Piece::O;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const RootMoveScore& root_move : scores) {
+        board.MakeMove(root_move.move, piece);
+        child_scores.insert(board.Hash(), root_move.score);
+        board.UnmakeMove(root_move.move);
+    }
+    return true;
+}
+
+}
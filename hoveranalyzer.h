@@ -0,0 +1,62 @@
+#ifndef HOVERANALYZER_H
+#define HOVERANALYZER_H
+
+#include "ai.h"
+#include "board.h"
+#include "gamestate.h"
+#include "transpositiontable.h"
+#include <QHash>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace ai {
+
+// Scores every move of a position in a background thread as soon as the
+// position is on the screen, so the GUI can show the score of the square
+// under the mouse without searching.
+//
+// Scores are kept per child position, the position right after the move,
+// from the point of view of the side that made the move. They are never
+// dropped: on the classic board every position is reached again in later
+// games, and the whole game tree fits in a few thousand entries.
+//
+// Start() and Stop() never wait: every run has its own stop flag, and a
+// superseded run finishes in the background and drops its results.
+class HoverAnalyzer {
+public:
+    HoverAnalyzer();
+    ~HoverAnalyzer();
+    // Abandons the previous position. on_finished is called on the background
+    // thread once all the children of board are scored.
+    void Start(SideToMove side, const Board& board, int depth,
+               const std::function<void()>& on_finished);
+    // Abandons the current position.
+    void Stop();
+    // Never waits for the search, safe to call while it runs.
+    bool Probe(quint64 child_key, int* score) const;
+    bool IsRunning() const;
+private:
+    void Run(std::shared_ptr<std::atomic<bool>> run_stop, SideToMove side, Board board, int depth,
+             std::function<void()> on_finished);
+    // Returns false if the run was stopped before all the children were scored.
+    bool Analyze(const std::atomic<bool>& run_stop, SideToMove side, Board board, int depth);
+
+    // Stop flag of the latest run, only used by the GUI thread.
+    std::shared_ptr<std::atomic<bool>> stop;
+    // Held by a run while it searches. Kept between positions, so the next
+    // position is mostly scored from the table.
+    std::mutex table_mutex;
+    TranspositionTable table;
+    // Guards child_scores and num_runs.
+    mutable std::mutex mutex;
+    std::condition_variable runs_finished;
+    int num_runs;
+    QHash<quint64, int> child_scores;
+};
+
+}
+
+#endif // HOVERANALYZER_H
@@ -1,11 +1,21 @@
 #include "mainwindow.h"
+#include "trace.h"
+#include "startup.h"
 #include <QApplication>
 #include <QDebug>
 
 int main(int argc, char *argv[])
 {
+    startup::Start();
+    // TICTACTOE_TRACE=<file> records a trace from startup and writes it on exit.
+    QByteArray trace_path = qgetenv("TICTACTOE_TRACE");
+    trace::SetEnabled(!trace_path.isEmpty());
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
-    return a.exec();
+    int exit_code = a.exec();
+    if (!trace_path.isEmpty() && !trace::DumpToFile(trace_path.toStdString())) {
+        qDebug() << "Failed to write trace to" << trace_path;
+    }
+    return exit_code;
 }
@@ -1,6 +1,10 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "ai.h"
+#include "trace.h"
+#include "ntuple.h"
+#include "simulwindow.h"
+#include "startup.h"
 #include <QDebug>
 #include <QPaintEvent>
 #include <QPainter>
@@ -9,8 +13,20 @@
 #include <QApplication>
 #include <QPixmap>
 #include <QIcon>
+#include <QFileDialog>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QInputDialog>
+#include <QCursor>
+#include <QImage>
+#include <QtConcurrent>
 
 constexpr int kSquareSizeScaleFactor = 6;
+// Empty space around the board, in squares.
+constexpr int kBoardMarginInSquares = kSquareSizeScaleFactor - kNumRows;
+// The layers of Qubic and the sub-boards of Ultimate are half a square apart.
+constexpr int kBlockGapScaleFactor = 2;
 constexpr int kSquareSizeInPx = kWindowWidthInPx / kSquareSizeScaleFactor;
 constexpr int kPenWidthInPx = 8;
 constexpr int kPenScaleFactor = 10;
@@ -24,23 +40,81 @@ constexpr int kCircleRadius = kSquareSizeInPx / 2 - 3 * kPenWidthInPx / 4;
 // kCircleCoeff is used to adjust the circle radius depending on the square size and pen's width
 constexpr double kCircleCoeff = 5.0 / 5;
 
+// Opacity of the analysis heatmap for a drawn and for a won or lost square.
+constexpr int kHeatmapMinAlpha = 60;
+constexpr int kHeatmapMaxAlpha = 180;
+
+// The classic board has fewer than 6000 positions, so a small file is plenty.
+constexpr int kPersistentCacheSizeInMb = 1;
+const QString kPersistentCacheFileName = QString("positions.cache");
+
+// A full-width Qubic search is out of reach, so the computer searches as deep
+// as it gets in the time limit.
+constexpr int kQubicSearchDepth = 4;
+constexpr int kQubicMoveTimeMs = 2000;
+constexpr int kUltimateSearchDepth = 8;
+constexpr int kUltimateMoveTimeMs = 2000;
+// The table of the large variants is kept between moves, up to this many
+// positions.
+constexpr int kMaxEngineTableSize = 1 << 20;
+// Opacity of the sub-boards of Ultimate that may be played and that are won.
+constexpr int kPlayableSubBoardAlpha = 60;
+constexpr int kWonSubBoardAlpha = 90;
+
+// Numbers of games a simul can show: full 4x4, 6x6 and 8x8 grids.
+const QStringList kSimulSizes = QStringList() << "16" << "36" << "64";
+constexpr int kSimulWindowSizeInPx = 800;
+
 constexpr int kMenuIconWidthInPx = 30;
 constexpr int kMenuIconHeightInPx = 30;
 
+namespace {
+
+// Runs on the thread pool, with its own copy of the position.
+template <typename BoardType>
+Move FindComputerMove(SideToMove side, BoardType board, const ai::EngineConfig& config,
+                      TranspositionTable* table, const std::atomic<bool>* stop, unsigned seed) {
+    TRACE_SCOPE("engine", "FindComputerMove");
+    std::mt19937 search_rng(seed);
+    ai::SearchContext context;
+    context.table = table;
+    context.stop = stop;
+    context.rng = &search_rng;
+    return ai::GetEngineMove(side, board, config, &context);
+}
+
+}
+
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
+    has_hover_analysis(false),
+    hover_analysis_key(0),
+    is_hover_evaluation_shown(true),
+    is_hover_message_shown(false),
     is_fullscreen(false),
+    is_pondering_enabled(true),
+    is_analysis_shown(false),
+    rng(std::random_device()()),
+    computer_move_stop(false),
+    computer_move_key(0),
+    analysis_key(0),
+    analysis_stop(false),
+    pending_analysis_key(0),
     window_width(kWindowWidthInPx),
     window_height(kWindowHeightInPx),
     square_size_in_px(kSquareSizeInPx),
     board_width(kBoardWidthInPx),
     board_height(kBoardHeightInPx),
     circle_radius(kCircleRadius),
+    block_rows(kNumRows),
+    block_cols(kNumCols),
+    block_gap(0),
     offset_x(kXOffsetInPx),
     offset_y(kYOffsetInPx),
-    pen_width(kPenWidthInPx)
+    pen_width(kPenWidthInPx),
+    is_engine_ready(false)
 {
     ui->setupUi(this);
     setMouseTracking(true);
@@ -51,41 +125,142 @@ MainWindow::MainWindow(QWidget *parent) :
     setWindowTitle(kWindowTitle);
     CreateActions();
     CreateMenus();
+    connect(&computer_move_watcher, SIGNAL(finished()), this, SLOT(on_computer_move_found()));
+    connect(&analysis_watcher, SIGNAL(finished()), this, SLOT(on_analysis_found()));
+    // Nothing is read from disk before the first frame: the icons and the
+    // engine data load on the thread pool and arrive when they are ready.
+    LoadIconsInBackground();
+    WarmUpEngineInBackground();
+    OnPositionChanged();
 }
 
 MainWindow::~MainWindow() {
+    // The searches use engine_table and analysis_table.
+    StopComputerMoveSearch();
+    StopAnalysis();
+    // The warm-up writes to persistent_cache.
+    engine_watcher.waitForFinished();
+    icon_watcher.waitForFinished();
     delete ui;
 }
 
+void MainWindow::SetIconLater(QAction* action, const QString& path) {
+    pending_icons.append(qMakePair(action, path));
+}
+
+void MainWindow::LoadIconsInBackground() {
+    QStringList paths;
+    for (const auto& icon : pending_icons) {
+        paths.append(icon.second);
+    }
+    connect(&icon_watcher, SIGNAL(finished()), this, SLOT(on_icons_loaded()));
+    // QImage, unlike QPixmap, may be decoded off the UI thread.
+    icon_watcher.setFuture(QtConcurrent::run([paths]() {
+        TRACE_SCOPE("startup", "LoadIcons");
+        QVector<QImage> images;
+        for (const QString& path : paths) {
+            images.append(QImage(path));
+        }
+        return images;
+    }));
+}
+
+void MainWindow::on_icons_loaded() {
+    QVector<QImage> images = icon_watcher.result();
+    for (int i = 0; i < pending_icons.size(); ++i) {
+        pending_icons[i].first->setIcon(QIcon(QPixmap::fromImage(images[i])));
+    }
+    pending_icons.clear();
+}
+
+void MainWindow::WarmUpEngineInBackground() {
+    // Until the warm-up finishes the position cache belongs to it.
+    persistent_cache_action->setEnabled(false);
+    std::string weights_path = QFile::encodeName(QApplication::applicationDirPath() + "/" +
+                                                 ntuple::kDefaultWeightsFileName).toStdString();
+    Board board = GetGameState().GetBoard();
+    connect(&engine_watcher, SIGNAL(finished()), this, SLOT(on_engine_ready()));
+    // Any other tables the engine needs at startup belong here too.
+    engine_watcher.setFuture(QtConcurrent::run([this, weights_path, board]() {
+        TRACE_SCOPE("startup", "WarmUpEngine");
+        ntuple::LoadDefaultNetwork(weights_path);
+        return OpenPersistentCacheFile(board);
+    }));
+}
+
+void MainWindow::on_engine_ready() {
+    // The boards made from now on take the network themselves.
+    GetGameState().GetBoard().SetNetwork(ntuple::GetDefaultNetwork());
+    bool is_cache_open = engine_watcher.result();
+    if (is_cache_open) {
+        ponderer.SetPersistentCache(&persistent_cache);
+    }
+    persistent_cache_action->setChecked(is_cache_open);
+    persistent_cache_action->setEnabled(true);
+    is_engine_ready = true;
+    startup::MarkEngineReady();
+}
+
 void MainWindow::CreateActions() {
     new_game_action = new QAction(tr("&New Game"), this);
     new_game_action->setShortcut(tr("Ctrl+N"));
     new_game_action->setStatusTip(tr("Start new game"));
-    new_game_action->setIcon(QIcon(":/images/menu_icons/play.jpg"));
+    SetIconLater(new_game_action, ":/images/menu_icons/play.jpg");
     connect(new_game_action, SIGNAL(triggered()), this, SLOT(on_new_game_action_triggered()));
     //connect(this, &Menu::, this, &MainWindow::on_new_game_act_triggered);
     //computer_mode_alignment_group = new QActionGroup(this);
     //computer_mode_alignment_group->addAction
 
+    undo_action = new QAction(tr("&Undo"), this);
+    undo_action->setShortcut(tr("Ctrl+Z"));
+    undo_action->setStatusTip(tr("Take back your last move"));
+    connect(undo_action, SIGNAL(triggered()), this, SLOT(on_undo_action_triggered()));
+
+    redo_action = new QAction(tr("&Redo"), this);
+    redo_action->setShortcut(tr("Ctrl+Y"));
+    redo_action->setStatusTip(tr("Play the taken back move again"));
+    connect(redo_action, SIGNAL(triggered()), this, SLOT(on_redo_action_triggered()));
+
     exit_action = new QAction(tr("&Exit"), this);
     exit_action->setShortcut(tr("Ctrl+Q"));
     exit_action->setStatusTip(tr("Exit"));
-    exit_action->setIcon(QIcon(":/images/menu_icons/exit.jpg"));
+    SetIconLater(exit_action, ":/images/menu_icons/exit.jpg");
     exit_action->setToolTip("LOOOOOOOOOOL");
     connect(exit_action, SIGNAL(triggered()), this, SLOT(on_exit_action_triggered()));
 
     toggle_fullscreen_action = new QAction(tr("&Toggle fullscreen"), this);
     toggle_fullscreen_action->setShortcut(tr("Ctrl+F"));
     toggle_fullscreen_action->setStatusTip(tr("Toggle fullscreen"));
-    toggle_fullscreen_action->setIcon(QIcon(":/images/menu_icons/fullscreen.jpg"));
+    SetIconLater(toggle_fullscreen_action, ":/images/menu_icons/fullscreen.jpg");
     connect(toggle_fullscreen_action, SIGNAL(triggered()), this, SLOT(on_toggle_fullscreen_action_triggered()));
 
     about_action = new QAction(tr("&About"), this);
     about_action->setShortcut(tr("&Ctrl+A"));
     about_action->setStatusTip(tr("About"));
-    about_action->setIcon(QIcon(":/images/menu_icons/about.jpg"));
+    SetIconLater(about_action, ":/images/menu_icons/about.jpg");
     connect(about_action, SIGNAL(triggered()), this, SLOT(on_about_action_triggered()));
 
+    classic_variant_action = new QAction(tr("&Classic 3x3"), this);
+    classic_variant_action->setStatusTip(tr("Play tic-tac-toe on a 3x3 board"));
+    classic_variant_action->setCheckable(true);
+    connect(classic_variant_action, SIGNAL(triggered()), this, SLOT(on_classic_variant_action_triggered()));
+
+    qubic_variant_action = new QAction(tr("&Qubic 4x4x4"), this);
+    qubic_variant_action->setStatusTip(tr("Play 3D tic-tac-toe on four stacked 4x4 layers"));
+    qubic_variant_action->setCheckable(true);
+    connect(qubic_variant_action, SIGNAL(triggered()), this, SLOT(on_qubic_variant_action_triggered()));
+
+    ultimate_variant_action = new QAction(tr("&Ultimate"), this);
+    ultimate_variant_action->setStatusTip(tr("Play on a 3x3 grid of boards, your move picks the next board"));
+    ultimate_variant_action->setCheckable(true);
+    connect(ultimate_variant_action, SIGNAL(triggered()), this, SLOT(on_ultimate_variant_action_triggered()));
+
+    variant_action_group = new QActionGroup(this);
+    variant_action_group->addAction(classic_variant_action);
+    variant_action_group->addAction(qubic_variant_action);
+    variant_action_group->addAction(ultimate_variant_action);
+    classic_variant_action->setChecked(true);
+
     computer_plays_x_action = new QAction(tr("&Computer plays X"), this);
     connect(computer_plays_x_action, SIGNAL(triggered()), this, SLOT(on_computer_plays_x_action_triggered()));
 
@@ -117,17 +292,60 @@ void MainWindow::CreateActions() {
     ai_action_group->addAction(ai_minimax_action);
     ai_random_action->setChecked(true);
 
+    ponder_action = new QAction(tr("&Ponder"), this);
+    ponder_action->setStatusTip(tr("Let the computer think while it is your turn"));
+    ponder_action->setCheckable(true);
+    ponder_action->setChecked(is_pondering_enabled);
+    connect(ponder_action, SIGNAL(triggered()), this, SLOT(on_ponder_action_triggered()));
+
+    persistent_cache_action = new QAction(tr("Remember &positions"), this);
+    persistent_cache_action->setStatusTip(tr("Keep computer's search results on disk between games"));
+    persistent_cache_action->setCheckable(true);
+    connect(persistent_cache_action, SIGNAL(triggered()), this, SLOT(on_persistent_cache_action_triggered()));
+
+    show_analysis_action = new QAction(tr("Show &analysis"), this);
+    show_analysis_action->setShortcut(tr("Ctrl+E"));
+    show_analysis_action->setStatusTip(tr("Show the score of every move for the side to move"));
+    show_analysis_action->setCheckable(true);
+    connect(show_analysis_action, SIGNAL(triggered()), this, SLOT(on_show_analysis_action_triggered()));
+
+    hover_evaluation_action = new QAction(tr("Show &hover evaluation"), this);
+    hover_evaluation_action->setStatusTip(tr("Show the outcome of the move under the mouse"));
+    hover_evaluation_action->setCheckable(true);
+    hover_evaluation_action->setChecked(is_hover_evaluation_shown);
+    connect(hover_evaluation_action, SIGNAL(triggered()), this, SLOT(on_hover_evaluation_action_triggered()));
+
+    simul_action = new QAction(tr("&Simul..."), this);
+    simul_action->setStatusTip(tr("Watch the computer play many games of the current variant at once"));
+    connect(simul_action, SIGNAL(triggered()), this, SLOT(on_simul_action_triggered()));
+
+    record_trace_action = new QAction(tr("&Record trace"), this);
+    record_trace_action->setStatusTip(tr("Record timings of UI and engine events"));
+    record_trace_action->setCheckable(true);
+    record_trace_action->setChecked(trace::IsEnabled());
+    connect(record_trace_action, SIGNAL(triggered()), this, SLOT(on_record_trace_action_triggered()));
+
+    dump_trace_action = new QAction(tr("&Save trace..."), this);
+    dump_trace_action->setStatusTip(tr("Save recorded timings in Chrome trace format"));
+    connect(dump_trace_action, SIGNAL(triggered()), this, SLOT(on_dump_trace_action_triggered()));
 
     help_action = new QAction(tr("&Help"), this);
     help_action->setShortcut(tr("Ctrl+H"));
     help_action->setStatusTip(tr("Help"));
-    help_action->setIcon(QIcon(":/images/menu_icons/help.jpg"));
+    SetIconLater(help_action, ":/images/menu_icons/help.jpg");
     connect(help_action, SIGNAL(triggered()), this, SLOT(on_help_action_triggered()));
 }
 
 void MainWindow::CreateMenus() {
     game_menu = menuBar()->addMenu(tr("&Game"));
     game_menu->addAction(new_game_action);
+    game_menu->addAction(undo_action);
+    game_menu->addAction(redo_action);
+    variant_menu = new QMenu(tr("&Variant"));
+    variant_menu->addAction(classic_variant_action);
+    variant_menu->addAction(qubic_variant_action);
+    variant_menu->addAction(ultimate_variant_action);
+    game_menu->addMenu(variant_menu);
     game_menu->addSeparator();
     game_menu->addAction(exit_action);
 
@@ -144,9 +362,17 @@ void MainWindow::CreateMenus() {
     ai_algorithm_menu->addAction(ai_random_action);
     ai_algorithm_menu->addAction(ai_minimax_action);
     settings_menu->addMenu(ai_algorithm_menu);
+    settings_menu->addAction(ponder_action);
+    settings_menu->addAction(persistent_cache_action);
+    settings_menu->addSeparator();
+    settings_menu->addAction(record_trace_action);
+    settings_menu->addAction(dump_trace_action);
 
     window_menu = menuBar()->addMenu(tr("Window"));
     window_menu->addAction(toggle_fullscreen_action);
+    window_menu->addAction(show_analysis_action);
+    window_menu->addAction(hover_evaluation_action);
+    window_menu->addAction(simul_action);
 
     help_menu = menuBar()->addMenu(tr("&Help"));
     help_menu->addAction(about_action);
@@ -154,10 +380,12 @@ void MainWindow::CreateMenus() {
 }
 
 void MainWindow::UpdateBoardRectParameters() {
+    TRACE_SCOPE("ui", "MainWindow::UpdateBoardRectParameters");
     rects.clear();
-    for (int row = 0; row < 3; ++row) {
-        for (int col = 0; col < 3; ++col){
-            QRect rect(offset_x + col * square_size_in_px, offset_y + row * square_size_in_px,
+    for (int row = 0; row < GetGameState().NumRows(); ++row) {
+        for (int col = 0; col < GetGameState().NumCols(); ++col){
+            QRect rect(offset_x + col * square_size_in_px + col / block_cols * block_gap,
+                       offset_y + row * square_size_in_px + row / block_rows * block_gap,
                        square_size_in_px, square_size_in_px);
             rects.append(rect);
         }
@@ -165,15 +393,33 @@ void MainWindow::UpdateBoardRectParameters() {
 }
 
 void MainWindow::UpdateWindowParameters() {
+    TRACE_SCOPE("ui", "MainWindow::UpdateWindowParameters");
     window_width = centralWidget()->geometry().width();
     window_height = centralWidget()->geometry().height();
-    square_size_in_px = qMin(window_width, window_height) / kSquareSizeScaleFactor;
-    board_width = square_size_in_px * kNumCols;
-    board_height = square_size_in_px * kNumRows;
-    circle_radius = square_size_in_px / 2 - kCircleCoeff * kPenWidthInPx;
+    int num_rows = GetGameState().NumRows();
+    int num_cols = GetGameState().NumCols();
+    if (GetGameState().GetVariant() == GameVariant::kQubic) {
+        block_rows = kQubicSize;
+        block_cols = num_cols;
+    } else if (GetGameState().GetVariant() == GameVariant::kUltimate) {
+        block_rows = block_cols = kUltimateSubBoardSize;
+    } else {
+        block_rows = num_rows;
+        block_cols = num_cols;
+    }
+    int num_row_gaps = num_rows / block_rows - 1;
+    int num_col_gaps = num_cols / block_cols - 1;
+    square_size_in_px = qMin(kBlockGapScaleFactor * window_width /
+                             (kBlockGapScaleFactor * (num_cols + kBoardMarginInSquares) + num_col_gaps),
+                             kBlockGapScaleFactor * window_height /
+                             (kBlockGapScaleFactor * (num_rows + kBoardMarginInSquares) + num_row_gaps));
+    block_gap = square_size_in_px / kBlockGapScaleFactor;
+    board_width = square_size_in_px * num_cols + block_gap * num_col_gaps;
+    board_height = square_size_in_px * num_rows + block_gap * num_row_gaps;
+    pen_width = square_size_in_px / kPenScaleFactor;
+    circle_radius = square_size_in_px / 2 - kCircleCoeff * pen_width;
     offset_x = (window_width - board_width) / 2;
     offset_y = (window_height - board_height) / 2 + kWindowVerticalOffsetInPx;
-    pen_width = square_size_in_px / kPenScaleFactor;
     UpdateBoardRectParameters();
 }
 
@@ -182,49 +428,205 @@ int MainWindow::GetSquareSizeInPx() {
 }
 
 void MainWindow::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("ui", "MainWindow::paintEvent");
     UpdateWindowParameters();
     QPainter painter(this);
+    if (is_analysis_shown && GetGameState().GetVariant() == GameVariant::kClassic &&
+            !GetGameState().IsGameFinished()) {
+        DrawAnalysis(painter);
+    }
+    if (GetGameState().GetVariant() == GameVariant::kUltimate) {
+        DrawSubBoards(painter);
+    }
     for (const auto& rect : rects) {
         painter.drawPolygon(rect);
     }
 
     QPen pen;
     pen.setWidth(pen_width);
-    for (int i = 0; i < kNumSquares; ++i) {
-        int row = i / kNumRows;
-        int col = i % kNumCols;
-        int ox = offset_x;
-        int oy = offset_y;
+    int num_cols = GetGameState().NumCols();
+    for (int i = 0; i < rects.size(); ++i) {
+        int row = i / num_cols;
+        int col = i % num_cols;
+        int x = rects[i].x();
+        int y = rects[i].y();
         int sqsz = square_size_in_px;
         int r = circle_radius;
-        if (GetGameState().GetBoard().At(row, col) == Piece::NoPiece) {
+        Piece piece = GetGameState().PieceAt(row, col);
+        if (piece == Piece::NoPiece) {
             continue;
-        } else if (GetGameState().GetBoard().At(row, col) == Piece::X) {
+        } else if (piece == Piece::X) {
             pen.setColor(Qt::red);
             pen.setCapStyle(Qt::RoundCap);
             painter.setPen(pen);
-            painter.drawLine(ox + col * sqsz + pen_width,
-                             oy + row * sqsz + pen_width,
-                             ox + col * sqsz + sqsz - pen_width,
-                             oy + row * sqsz + sqsz - pen_width);
-            painter.drawLine(ox + col * sqsz + sqsz - pen_width,
-                             oy + row * sqsz + pen_width,
-                             ox + col * sqsz + pen_width,
-                             oy + row * sqsz + sqsz - pen_width);
-        } else if (GetGameState().GetBoard().At(row, col) == Piece::O) {
+            painter.drawLine(x + pen_width, y + pen_width, x + sqsz - pen_width, y + sqsz - pen_width);
+            painter.drawLine(x + sqsz - pen_width, y + pen_width, x + pen_width, y + sqsz - pen_width);
+        } else if (piece == Piece::O) {
             pen.setColor(Qt::green);
             painter.setPen(pen);
-            painter.drawEllipse(QPoint(ox + col * sqsz + sqsz / 2, oy + row * sqsz + sqsz / 2),
-                                r, r);
+            painter.drawEllipse(QPoint(x + sqsz / 2, y + sqsz / 2), r, r);
+        }
+    }
+    startup::MarkFirstPaint();
+}
+
+void MainWindow::UpdateAnalysis() {
+    if (!is_analysis_shown || GetGameState().GetVariant() != GameVariant::kClassic ||
+            GetGameState().IsGameFinished()) {
+        return;
+    }
+    quint64 key = GetGameState().GetBoard().Hash();
+    if ((!analysis.empty() && analysis_key == key) ||
+            (analysis_watcher.isRunning() && pending_analysis_key == key)) {
+        return;
+    }
+    StopAnalysis();
+    analysis_stop = false;
+    pending_analysis_key = key;
+    SideToMove side = GetGameState().GetSideToMove();
+    Board board = GetGameState().GetBoard();
+    ai::SearchContext context = MakeSearchContext(&analysis_table);
+    context.stop = &analysis_stop;
+    analysis_watcher.setFuture(QtConcurrent::run([side, board, context]() mutable {
+        return ai::AnalyzeRoot(side, board, ai::kDefaultMinimaxDepth, &context, true);
+    }));
+}
+
+void MainWindow::StopAnalysis() {
+    analysis_stop = true;
+    analysis_watcher.waitForFinished();
+}
+
+void MainWindow::on_analysis_found() {
+    // A stopped search has made-up scores.
+    if (analysis_stop || GetGameState().GetBoard().Hash() != pending_analysis_key) {
+        return;
+    }
+    analysis = analysis_watcher.result();
+    analysis_key = pending_analysis_key;
+    update();
+}
+
+void MainWindow::DrawAnalysis(QPainter& painter) {
+    TRACE_SCOPE("ui", "MainWindow::DrawAnalysis");
+    // Only the analysis of the position on the screen, see UpdateAnalysis().
+    if (analysis_key != GetGameState().GetBoard().Hash()) {
+        return;
+    }
+    painter.save();
+    painter.setPen(Qt::black);
+    for (const auto& root_move : analysis) {
+        const QRect& rect = rects[root_move.move.row * kNumCols + root_move.move.col];
+        int magnitude = qMin(qAbs(root_move.score), kWinEval);
+        QColor color = root_move.score > 0 ? QColor(Qt::green) :
+                       root_move.score < 0 ? QColor(Qt::red) : QColor(Qt::gray);
+        color.setAlpha(kHeatmapMinAlpha + (kHeatmapMaxAlpha - kHeatmapMinAlpha) * magnitude / kWinEval);
+        painter.fillRect(rect, color);
+        // The moves worse than the best one only have an upper bound.
+        QString text = QString::number(root_move.score);
+        if (root_move.is_upper_bound) {
+            text.prepend(QChar(0x2264));
         }
+        painter.drawText(rect.adjusted(pen_width, pen_width, -pen_width, -pen_width),
+                         Qt::AlignRight | Qt::AlignBottom, text);
+    }
+    painter.restore();
+}
+
+void MainWindow::DrawSubBoards(QPainter& painter) {
+    const UltimateBoard& board = GetGameState().GetUltimateBoard();
+    for (int sub_board = 0; sub_board < kUltimateNumSubBoards; ++sub_board) {
+        QColor color;
+        Piece winner = board.GetSubBoardWinner(sub_board);
+        if (winner != Piece::NoPiece) {
+            color = (winner == Piece::X) ? QColor(Qt::red) : QColor(Qt::green);
+            color.setAlpha(kWonSubBoardAlpha);
+        } else if (!GetGameState().IsGameFinished() && !board.IsSubBoardClosed(sub_board) &&
+                   (board.GetForcedSubBoard() == kNoForcedSubBoard ||
+                    board.GetForcedSubBoard() == sub_board)) {
+            color = QColor(Qt::yellow);
+            color.setAlpha(kPlayableSubBoardAlpha);
+        } else {
+            continue;
+        }
+        int first_row = sub_board / kUltimateSubBoardSize * kUltimateSubBoardSize;
+        int first_col = sub_board % kUltimateSubBoardSize * kUltimateSubBoardSize;
+        const QRect& first = rects[first_row * kUltimateSize + first_col];
+        const QRect& last = rects[(first_row + kUltimateSubBoardSize - 1) * kUltimateSize +
+                                  first_col + kUltimateSubBoardSize - 1];
+        painter.fillRect(first.united(last), color);
     }
 }
 
 void MainWindow::mouseMoveEvent(QMouseEvent *event) {
+    TRACE_SCOPE("ui", "MainWindow::mouseMoveEvent");
     update();
+    UpdateHoverStatus();
+}
+
+void MainWindow::OnPositionChanged() {
+    UpdateAnalysis();
+    StartHoverAnalysis();
+}
+
+void MainWindow::StartHoverAnalysis() {
+    if (!is_hover_evaluation_shown || GetGameState().GetVariant() != GameVariant::kClassic ||
+            GetGameState().IsGameFinished()) {
+        return;
+    }
+    quint64 key = GetGameState().GetBoard().Hash();
+    if (has_hover_analysis && hover_analysis_key == key) {
+        return;
+    }
+    has_hover_analysis = true;
+    hover_analysis_key = key;
+    hover_analyzer.Start(GetGameState().GetSideToMove(), GetGameState().GetBoard(),
+                         ai::kDefaultMinimaxDepth, [this]() {
+        QMetaObject::invokeMethod(this, "UpdateHoverStatus", Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::UpdateHoverStatus() {
+    TRACE_SCOPE("ui", "MainWindow::UpdateHoverStatus");
+    QString message;
+    if (is_hover_evaluation_shown && GetGameState().GetVariant() == GameVariant::kClassic &&
+            !GetGameState().IsGameFinished()) {
+        QPoint pos = mapFromGlobal(QCursor::pos());
+        int num_cols = GetGameState().NumCols();
+        for (int i = 0; i < rects.size(); ++i) {
+            Move move(i / num_cols, i % num_cols);
+            if (rects[i].contains(pos) && GetGameState().IsValidMove(move)) {
+                message = GetHoverMessage(move);
+                break;
+            }
+        }
+    }
+    if (!message.isEmpty()) {
+        statusBar()->showMessage(message);
+        is_hover_message_shown = true;
+    } else if (is_hover_message_shown) {
+        statusBar()->clearMessage();
+        is_hover_message_shown = false;
+    }
+}
+
+QString MainWindow::GetHoverMessage(const Move& move) const {
+    Board board = GetGameState().GetBoard();
+    board.MakeMove(move, GetGameState().GetPieceToMove());
+    QString square = tr("Row %1, column %2: ").arg(move.row + 1).arg(move.col + 1);
+    int score = 0;
+    if (!hover_analyzer.Probe(board.Hash(), &score)) {
+        return square + tr("evaluating...");
+    }
+    bool is_x_to_move = GetGameState().GetSideToMove() == SideToMove::X;
+    if (score == 0) {
+        return square + tr("draw");
+    }
+    return square + ((score > 0) == is_x_to_move ? tr("X wins") : tr("O wins"));
 }
 
 void MainWindow::mousePressEvent(QMouseEvent *event) {
+    TRACE_SCOPE("ui", "MainWindow::mousePressEvent");
     if (GetGameState().GetPlayerToMove() == Player::Computer) {
         return;
     }
@@ -232,29 +634,34 @@ void MainWindow::mousePressEvent(QMouseEvent *event) {
         int x = event->pos().x();
         int y = event->pos().y();
         for (int i = 0; i < rects.size(); ++i) {
-            int row = i / kNumRows;
-            int col = i % kNumCols;
+            int row = i / GetGameState().NumCols();
+            int col = i % GetGameState().NumCols();
             Move player_move(row, col);
-            if (rects[i].contains(QPoint(x, y)) && GetGameState().GetBoard().At(row, col) == Piece::NoPiece) {
+            if (rects[i].contains(QPoint(x, y)) && GetGameState().IsValidMove(player_move)) {
                 GetGameState().MakeMove(player_move);
                 if (GetGameState().IsGameFinished()) {
                     QMessageBox msgBox;
                     msgBox.setText(GetGameState().GetGameOutcomeText());
-                    msgBox.exec();
+                    {
+                        TRACE_SCOPE("ui", "QMessageBox::exec");
+                        msgBox.exec();
+                    }
+                    ponderer.Reset();
                     GetGameState().Reset();
-                    if (GetGameState().GetComputerMode() == ComputerMode::kPlaysX) {
+                    if (GetGameState().GetPlayerToMove() == Player::Computer) {
                         MakeComputerMove();
                     }
+                    OnPositionChanged();
                     return;
                 }
-                if (GetGameState().GetComputerMode() != ComputerMode::kObserves) {
-                    GetGameState().SwitchPlayerToMove();
+                if (GetGameState().GetPlayerToMove() == Player::Computer) {
                     MakeComputerMove();
                 }
                 break;
             }
         }
     }
+    OnPositionChanged();
     update();
 }
 
@@ -281,8 +688,85 @@ void MainWindow::on_exit_action_triggered() {
     QApplication::exit();
 }
 
+void MainWindow::on_undo_action_triggered() {
+    if (!GetGameState().CanUndo()) {
+        return;
+    }
+    StopComputerMoveSearch();
+    ponderer.Stop();
+    GetGameState().UndoTurn();
+    OnPositionChanged();
+    update();
+    if (GetGameState().GetPlayerToMove() == Player::Computer) {
+        MakeComputerMove();
+    } else {
+        StartPondering();
+    }
+}
+
+void MainWindow::on_redo_action_triggered() {
+    if (!GetGameState().CanRedo()) {
+        return;
+    }
+    StopComputerMoveSearch();
+    ponderer.Stop();
+    GetGameState().RedoTurn();
+    OnPositionChanged();
+    update();
+    if (GetGameState().IsGameFinished()) {
+        QMessageBox msgBox;
+        msgBox.setText(GetGameState().GetGameOutcomeText());
+        {
+            TRACE_SCOPE("ui", "QMessageBox::exec");
+            msgBox.exec();
+        }
+        ponderer.Reset();
+        GetGameState().Reset();
+        OnPositionChanged();
+        update();
+    }
+    if (GetGameState().GetPlayerToMove() == Player::Computer) {
+        MakeComputerMove();
+    } else {
+        StartPondering();
+    }
+}
+
+void MainWindow::on_classic_variant_action_triggered() {
+    SetVariant(GameVariant::kClassic);
+}
+
+void MainWindow::on_qubic_variant_action_triggered() {
+    SetVariant(GameVariant::kQubic);
+}
+
+void MainWindow::on_ultimate_variant_action_triggered() {
+    SetVariant(GameVariant::kUltimate);
+}
+
+void MainWindow::SetVariant(GameVariant variant) {
+    if (variant == GetGameState().GetVariant()) {
+        return;
+    }
+    StopComputerMoveSearch();
+    StopAnalysis();
+    ponderer.Reset();
+    analysis.clear();
+    // The hash keys of different variants may collide.
+    engine_table.Clear();
+    GetGameState().SetVariant(variant);
+    OnPositionChanged();
+    update();
+    if (GetGameState().GetPlayerToMove() == Player::Computer) {
+        MakeComputerMove();
+    }
+}
+
 void MainWindow::on_new_game_action_triggered() {
+    StopComputerMoveSearch();
+    ponderer.Reset();
     GetGameState().Reset();
+    OnPositionChanged();
     update();
     if (GetGameState().GetPlayerToMove() == Player::Computer) {
         MakeComputerMove();
@@ -307,32 +791,28 @@ void MainWindow::on_help_action_triggered() {
 }
 
 void MainWindow::on_computer_plays_x_action_triggered() {
+    StopComputerMoveSearch();
     GetGameState().SetComputerMode(ComputerMode::kPlaysX);
-    GetGameState().SetPlayerX(Player::Computer);
-    if (GetGameState().GetSideToMove() == SideToMove::X) {
-        GetGameState().SetPlayerToMove(Player::Computer);
-        qDebug() << "Set player to move to computer";
+    if (GetGameState().GetPlayerToMove() == Player::Computer) {
         MakeComputerMove();
     }
 }
 
 void MainWindow::on_computer_plays_o_action_triggered() {
+    StopComputerMoveSearch();
     GetGameState().SetComputerMode(ComputerMode::kPlaysO);
-    GetGameState().SetPlayerO(Player::Computer);
-    if (GetGameState().GetSideToMove() == SideToMove::O) {
-        GetGameState().SetPlayerToMove(Player::Computer);
+    if (GetGameState().GetPlayerToMove() == Player::Computer) {
         MakeComputerMove();
     }
 }
 
 void MainWindow::on_computer_observes_action_triggered() {
+    StopComputerMoveSearch();
     GetGameState().SetComputerMode(ComputerMode::kObserves);
-    GetGameState().SetPlayerX(Player::Human);
-    GetGameState().SetPlayerO(Player::Human);
-    GetGameState().SetPlayerToMove(Player::Human);
 }
 
 void MainWindow::on_ai_random_action_triggered() {
+    ponderer.Stop();
     GetGameState().SetAiAlgorithm(AiAlgorithm::kRandom);
 }
 
@@ -340,6 +820,13 @@ void MainWindow::on_ai_minimax_action_triggered() {
     GetGameState().SetAiAlgorithm(AiAlgorithm::kMinimax);
 }
 
+void MainWindow::on_ponder_action_triggered() {
+    is_pondering_enabled = ponder_action->isChecked();
+    if (!is_pondering_enabled) {
+        ponderer.Stop();
+    }
+}
+
 GameState& MainWindow::GetGameState() {
     return game_state;
 }
@@ -349,30 +836,197 @@ const GameState& MainWindow::GetGameState() const {
 }
 
 void MainWindow::MakeComputerMove() {
+    TRACE_SCOPE("ui", "MainWindow::MakeComputerMove");
     assert(GetGameState().GetPlayerToMove() == Player::Computer);
+    ponderer.Stop();
+    if (GetGameState().GetVariant() != GameVariant::kClassic) {
+        StartComputerMoveSearch();
+        return;
+    }
     Move computer_move;
     if (GetGameState().GetAiAlgorithm() == AiAlgorithm::kRandom) {
-        computer_move = ai::GetRandomeMove(GetGameState().GetSideToMove(),
-                GetGameState().GetBoard());
+        computer_move = ai::GetRandomeMove(GetGameState().GetBoard(), &rng);
     } else if (GetGameState().GetAiAlgorithm() == AiAlgorithm::kMinimax) {
-        computer_move = ai::GetMinimaxMove(GetGameState().GetSideToMove(),
-                                                GetGameState().GetBoard(),
-                                                ai::kDefaultMinimaxDepth);
+        // On a ponder hit the answer is already known. On a miss the search
+        // still reuses the positions the ponderer has cached.
+        if (!ponderer.Probe(GetGameState().GetBoard().Hash(), &computer_move)) {
+            ai::SearchContext context = MakeSearchContext(&ponderer.GetTable());
+            context.rng = &rng;
+            computer_move = ai::GetMinimaxMove(GetGameState().GetSideToMove(),
+                                                    GetGameState().GetBoard(),
+                                                    ai::kDefaultMinimaxDepth,
+                                                    &context);
+        }
     } else {
         assert(false);
     }
+    PlayComputerMove(computer_move);
+}
+
+void MainWindow::StartComputerMoveSearch() {
+    StopComputerMoveSearch();
+    ai::EngineConfig config;
+    config.algorithm = GetGameState().GetAiAlgorithm();
+    // Scores depend on the position only, so what the last searches
+    // learned about the positions ahead is still good.
+    if (engine_table.Size() > kMaxEngineTableSize) {
+        engine_table.Clear();
+    }
+    computer_move_stop = false;
+    computer_move_key = GetGameState().GetPositionHash();
+    SideToMove side = GetGameState().GetSideToMove();
+    TranspositionTable* table = &engine_table;
+    const std::atomic<bool>* stop = &computer_move_stop;
+    unsigned seed = rng();
+    if (GetGameState().GetVariant() == GameVariant::kQubic) {
+        config.depth = kQubicSearchDepth;
+        config.max_time_ms = kQubicMoveTimeMs;
+        QubicBoard board = GetGameState().GetQubicBoard();
+        computer_move_watcher.setFuture(QtConcurrent::run([side, board, config, table, stop, seed]() {
+            return FindComputerMove(side, board, config, table, stop, seed);
+        }));
+    } else {
+        config.depth = kUltimateSearchDepth;
+        config.max_time_ms = kUltimateMoveTimeMs;
+        UltimateBoard board = GetGameState().GetUltimateBoard();
+        computer_move_watcher.setFuture(QtConcurrent::run([side, board, config, table, stop, seed]() {
+            return FindComputerMove(side, board, config, table, stop, seed);
+        }));
+    }
+}
+
+void MainWindow::StopComputerMoveSearch() {
+    computer_move_stop = true;
+    computer_move_watcher.waitForFinished();
+}
+
+void MainWindow::on_computer_move_found() {
+    // A stopped search only has its fallback move, and after an undo or a new
+    // game the move is for a position that is gone.
+    if (computer_move_stop || GetGameState().GetPositionHash() != computer_move_key ||
+            GetGameState().GetPlayerToMove() != Player::Computer) {
+        return;
+    }
+    PlayComputerMove(computer_move_watcher.result());
+}
+
+void MainWindow::PlayComputerMove(const Move& computer_move) {
     GetGameState().MakeMove(computer_move);
     if (GetGameState().IsGameFinished()) {
         QMessageBox msgBox;
         msgBox.setText(GetGameState().GetGameOutcomeText());
-        msgBox.exec();
+        {
+            TRACE_SCOPE("ui", "QMessageBox::exec");
+            msgBox.exec();
+        }
+        ponderer.Reset();
         GetGameState().Reset();
-        if (GetGameState().GetComputerMode() == ComputerMode::kPlaysX ||
-                GetGameState().GetComputerMode() == ComputerMode::kPlaysBoth) {
+        if (GetGameState().GetPlayerToMove() == Player::Computer) {
             MakeComputerMove();
         }
     } else {
-        GetGameState().SwitchPlayerToMove();
+        StartPondering();
+    }
+    OnPositionChanged();
+    update();
+}
+
+void MainWindow::on_show_analysis_action_triggered() {
+    is_analysis_shown = show_analysis_action->isChecked();
+    if (!is_analysis_shown) {
+        StopAnalysis();
     }
+    UpdateAnalysis();
     update();
 }
+
+void MainWindow::on_hover_evaluation_action_triggered() {
+    is_hover_evaluation_shown = hover_evaluation_action->isChecked();
+    if (is_hover_evaluation_shown) {
+        StartHoverAnalysis();
+    } else {
+        hover_analyzer.Stop();
+        has_hover_analysis = false;
+    }
+    UpdateHoverStatus();
+    update();
+}
+
+void MainWindow::on_simul_action_triggered() {
+    bool ok = false;
+    QString size = QInputDialog::getItem(this, tr("Simul"), tr("Number of games:"), kSimulSizes,
+                                         0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    SimulWindow* simul_window = new SimulWindow(size.toInt(), GetGameState().GetVariant());
+    simul_window->setAttribute(Qt::WA_DeleteOnClose);
+    simul_window->resize(kSimulWindowSizeInPx, kSimulWindowSizeInPx);
+    simul_window->show();
+}
+
+void MainWindow::on_persistent_cache_action_triggered() {
+    // The analysis may be reading the cache.
+    StopAnalysis();
+    if (persistent_cache_action->isChecked()) {
+        persistent_cache_action->setChecked(OpenPersistentCache());
+    } else {
+        ponderer.SetPersistentCache(nullptr);
+        persistent_cache.Close();
+    }
+}
+
+void MainWindow::on_record_trace_action_triggered() {
+    trace::SetEnabled(record_trace_action->isChecked());
+}
+
+void MainWindow::on_dump_trace_action_triggered() {
+    QString path = QFileDialog::getSaveFileName(this, tr("Save trace"), "tictactoe_trace.json",
+                                                tr("Trace files (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!trace::DumpToFile(path.toStdString())) {
+        QMessageBox::warning(this, tr("Save trace"), tr("Could not write %1").arg(path));
+    }
+}
+
+ai::SearchContext MainWindow::MakeSearchContext(TranspositionTable* table) {
+    ai::SearchContext context;
+    context.table = table;
+    if (is_engine_ready && persistent_cache.Matches(GetGameState().GetBoard())) {
+        context.persistent_cache = &persistent_cache;
+    }
+    return context;
+}
+
+bool MainWindow::OpenPersistentCache() {
+    if (!OpenPersistentCacheFile(GetGameState().GetBoard())) {
+        return false;
+    }
+    ponderer.SetPersistentCache(&persistent_cache);
+    return true;
+}
+
+bool MainWindow::OpenPersistentCacheFile(const Board& board) {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (dir.isEmpty() || !QDir().mkpath(dir) ||
+            !persistent_cache.Open(QFile::encodeName(dir + "/" + kPersistentCacheFileName).toStdString(),
+                                   board.NumRows(),
+                                   board.NumCols(), board.WinLength(), kPersistentCacheSizeInMb)) {
+        qDebug() << "Could not open the position cache in" << dir;
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::StartPondering() {
+    if (!is_pondering_enabled || GetGameState().GetVariant() != GameVariant::kClassic ||
+            GetGameState().GetAiAlgorithm() != AiAlgorithm::kMinimax ||
+            GetGameState().GetPlayerToMove() != Player::Human) {
+        return;
+    }
+    SideToMove engine_side = (GetGameState().GetSideToMove() == SideToMove::X) ?
+                SideToMove::O : SideToMove::X;
+    ponderer.Start(engine_side, GetGameState().GetBoard(), ai::kDefaultMinimaxDepth);
+}
@@ -3,10 +3,18 @@
 
 #include "board.h"
 #include "gamestate.h"
+#include "ponder.h"
+#include "hoveranalyzer.h"
+#include "ai.h"
+#include "persistentcache.h"
 #include <QMainWindow>
 #include <QMenu>
 #include <QAction>
 #include <QActionGroup>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QPair>
+#include <random>
 
 constexpr int kWindowWidthInPx = 640;
 constexpr int kWindowHeightInPx = static_cast<int>(kWindowWidthInPx * 3.0 / 4);
@@ -35,19 +43,63 @@ signals:
 private:
     Ui::MainWindow *ui;
     GameState game_state;
+    // Declared before the ponderer, whose thread may use it until the ponderer
+    // is destroyed.
+    PersistentCache persistent_cache;
+    ai::Ponderer ponderer;
+    ai::HoverAnalyzer hover_analyzer;
+    bool has_hover_analysis;
+    quint64 hover_analysis_key;
+    bool is_hover_evaluation_shown;
+    bool is_hover_message_shown;
     QVector<QRect> rects;
     bool is_fullscreen;
+    bool is_pondering_enabled;
+    bool is_analysis_shown;
+    TranspositionTable analysis_table;
+    // The computer's table for Qubic and Ultimate, kept between its moves.
+    TranspositionTable engine_table;
+    // Picks the random moves and breaks ties between the best moves of the
+    // computer, so that it does not play the same game every time.
+    std::mt19937 rng;
+    // The computer's search in the large variants, which takes seconds and so
+    // runs on the thread pool. Its move is played when it finishes, unless
+    // the search was stopped or the position has changed since.
+    QFutureWatcher<Move> computer_move_watcher;
+    std::atomic<bool> computer_move_stop;
+    quint64 computer_move_key;
+    std::vector<ai::RootMoveScore> analysis;
+    quint64 analysis_key;
+    // The analysis runs on the thread pool and is shown when it finishes,
+    // unless it was stopped or the position has changed since.
+    QFutureWatcher<std::vector<ai::RootMoveScore>> analysis_watcher;
+    std::atomic<bool> analysis_stop;
+    quint64 pending_analysis_key;
     int window_width;
     int window_height;
     int square_size_in_px;
     int board_width;
     int board_height;
     int circle_radius;
+    // The board is drawn in blocks of block_rows x block_cols squares,
+    // block_gap apart: the layers of Qubic and the sub-boards of Ultimate.
+    int block_rows;
+    int block_cols;
+    int block_gap;
     int offset_x;
     int offset_y;
     int pen_width;
+    // Menu icons waiting for the background decoding to finish.
+    QVector<QPair<QAction*, QString>> pending_icons;
+    QFutureWatcher<QVector<QImage>> icon_watcher;
+    // The engine warm-up, whose result tells if the position cache opened.
+    QFutureWatcher<bool> engine_watcher;
+    // Set once the warm-up has finished; until then the searches run
+    // without the position cache.
+    bool is_engine_ready;
     //Menus
     QMenu *game_menu;
+    QMenu *variant_menu;
     QMenu *settings_menu;
     QMenu *computer_mode_menu;
     QMenu *ai_algorithm_menu;
@@ -56,6 +108,12 @@ private:
     //Actions
     QAction *new_game_action;
     QAction *exit_action;
+    QAction *undo_action;
+    QAction *redo_action;
+    QAction *classic_variant_action;
+    QAction *qubic_variant_action;
+    QAction *ultimate_variant_action;
+    QActionGroup *variant_action_group;
     QAction *toggle_fullscreen_action;
     QAction *about_action;
     QAction *help_action;
@@ -66,6 +124,13 @@ private:
     QAction *ai_random_action;
     QAction *ai_minimax_action;
     QActionGroup *ai_action_group;
+    QAction *ponder_action;
+    QAction *persistent_cache_action;
+    QAction *show_analysis_action;
+    QAction *simul_action;
+    QAction *hover_evaluation_action;
+    QAction *record_trace_action;
+    QAction *dump_trace_action;
 
 protected:
     void paintEvent(QPaintEvent *);
@@ -73,9 +138,21 @@ protected:
     void mousePressEvent(QMouseEvent *event);
     void CreateRects();
     void FillSquare(int ind, SideToMove side, QPainter& painter);
+    // Starts the search of the position on the screen if the analysis is
+    // shown. Called when the position changes; paintEvent only draws the
+    // result.
+    void UpdateAnalysis();
+    // Waits for the search, which stops at once.
+    void StopAnalysis();
+    void DrawAnalysis(QPainter& painter);
+    void DrawSubBoards(QPainter& painter);
     void CreateBoard();
     void CreateActions();
     void CreateMenus();
+    // Startup work moved off the path to the first frame.
+    void SetIconLater(QAction* action, const QString& path);
+    void LoadIconsInBackground();
+    void WarmUpEngineInBackground();
     //reset stuff
 
     //update stuff
@@ -86,10 +163,31 @@ protected:
     int GetSquareSizeInPx();
 
     void MakeComputerMove();
+    void StartComputerMoveSearch();
+    // Waits for the search, which stops at once.
+    void StopComputerMoveSearch();
+    void PlayComputerMove(const Move& computer_move);
+    ai::SearchContext MakeSearchContext(TranspositionTable* table);
+    bool OpenPersistentCache();
+    // Does not touch the ponderer, so the warm-up may call it on another
+    // thread.
+    bool OpenPersistentCacheFile(const Board& board);
+    void StartPondering();
+    // Starts the work that depends on the position on the screen. Called on
+    // every position change, so paintEvent only draws.
+    void OnPositionChanged();
+    void StartHoverAnalysis();
+    QString GetHoverMessage(const Move& move) const;
+    void SetVariant(GameVariant variant);
 
 private slots:
     void on_new_game_action_triggered();
     void on_exit_action_triggered();
+    void on_undo_action_triggered();
+    void on_redo_action_triggered();
+    void on_classic_variant_action_triggered();
+    void on_qubic_variant_action_triggered();
+    void on_ultimate_variant_action_triggered();
     void on_toggle_fullscreen_action_triggered();
     void on_about_action_triggered();
     void on_help_action_triggered();
@@ -98,6 +196,19 @@ private slots:
     void on_computer_observes_action_triggered();
     void on_ai_random_action_triggered();
     void on_ai_minimax_action_triggered();
+    void on_ponder_action_triggered();
+    void on_show_analysis_action_triggered();
+    void on_simul_action_triggered();
+    void on_hover_evaluation_action_triggered();
+    // Shows the score of the square under the mouse in the status bar.
+    void UpdateHoverStatus();
+    void on_persistent_cache_action_triggered();
+    void on_icons_loaded();
+    void on_engine_ready();
+    void on_computer_move_found();
+    void on_analysis_found();
+    void on_record_trace_action_triggered();
+    void on_dump_trace_action_triggered();
 };
 
 #endif // MAINWINDOW_H
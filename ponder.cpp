@@ -0,0 +1,96 @@
+#include "ponder.h"
+#include "trace.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace ai {
+
+Ponderer::Ponderer() : stop(false), persistent_cache(nullptr), rng(std::random_device()())
+{
+
+}
+
+Ponderer::~Ponderer() {
+    Stop();
+}
+
+void Ponderer::Start(SideToMove engine_side, const Board& board, int depth) {
+    Stop();
+    stop = false;
+    future = QtConcurrent::run([this, engine_side, board, depth]() {
+        Run(engine_side, board, depth);
+    });
+}
+
+void Ponderer::Stop() {
+    TRACE_SCOPE("engine", "ai::Ponderer::Stop");
+    stop = true;
+    future.waitForFinished();
+}
+
+void Ponderer::Reset() {
+    Stop();
+    replies.clear();
+}
+
+bool Ponderer::Probe(quint64 key, Move* move) const {
+    assert(!IsRunning());
+    if (!replies.contains(key)) {
+        return false;
+    }
+    *move = replies.value(key);
+    return true;
+}
+
+TranspositionTable& Ponderer::GetTable() {
+    assert(!IsRunning());
+    return table;
+}
+
+void Ponderer::SetPersistentCache(PersistentCache* cache) {
+    Stop();
+    persistent_cache = cache;
+}
+
+bool Ponderer::IsRunning() const {
+    return future.isRunning();
+}
+
+void Ponderer::Run(SideToMove engine_side, Board board, int depth) {
+    TRACE_SCOPE("engine", "ai::Ponderer::Run");
+    SideToMove human_side = (engine_side == SideToMove::X) ? SideToMove::O : SideToMove::X;
+    Piece human_piece = (human_side == SideToMove::X) ? Piece::X : Piece::O;
+    SearchContext context;
+    context.table = &table;
+    context.persistent_cache = persistent_cache;
+    context.stop = &stop;
+    context.rng = &rng;
+    std::vector<Move> human_moves = board.GenValidMoves();
+    if (human_moves.empty()) {
+        return;
+    }
+    // Search the reply we expect from the human first, it is the most likely
+    // to be played. This search also fills the table for the other replies.
+    Move expected = GetMinimaxMove(human_side, board, depth, &context);
+    auto it = std::find_if(human_moves.begin(), human_moves.end(), [&expected](const Move& move) {
+        return move.row == expected.row && move.col == expected.col;
+    });
+    if (it != human_moves.end()) {
+        std::iter_swap(human_moves.begin(), it);
+    }
+    for (const Move& human_move : human_moves) {
+        if (context.IsStopped()) {
+            return;
+        }
+        board.MakeMove(human_move, human_piece);
+        if (!board.IsTerminalNode()) {
+            Move engine_move = GetMinimaxMove(engine_side, board, depth, &context);
+            if (!context.IsStopped()) {
+                replies.insert(board.Hash(), engine_move);
+            }
+        }
+        board.UnmakeMove(human_move);
+    }
+}
+
+}
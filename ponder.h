@@ -0,0 +1,56 @@
+#ifndef PONDER_H
+#define PONDER_H
+
+#include "ai.h"
+#include "board.h"
+#include "gamestate.h"
+#include "transpositiontable.h"
+#include <QFuture>
+#include <QHash>
+#include <atomic>
+#include <random>
+
+namespace ai {
+
+// Searches the replies of the human player in a background thread while the
+// GUI waits for the human's move. For every reply it records the move the
+// engine would answer with, and all searched positions end up in the table,
+// so a ponder miss still starts with a warm cache.
+//
+// Both the table and the replies are keyed by position alone. The table is
+// kept for good, so every search after the first one starts from what was
+// learned before. The replies are kept for the rest of the game, which makes
+// the searches after an undo free; a new game or variant drops them, since
+// their ties were broken at random and the next game should not repeat them.
+class Ponderer {
+public:
+    Ponderer();
+    ~Ponderer();
+    // board is the position right after the engine's move, with the human to move.
+    void Start(SideToMove engine_side, const Board& board, int depth);
+    // Blocks until the background search has finished. Must be called before
+    // Probe() or GetTable().
+    void Stop();
+    // Stops and forgets the replies found so far.
+    void Reset();
+    bool Probe(quint64 key, Move* move) const;
+    TranspositionTable& GetTable();
+    bool IsRunning() const;
+    // Searches started afterwards also read and write cache; null disables it.
+    void SetPersistentCache(PersistentCache* cache);
+private:
+    void Run(SideToMove engine_side, Board board, int depth);
+
+    QFuture<void> future;
+    std::atomic<bool> stop;
+    TranspositionTable table;
+    PersistentCache* persistent_cache;
+    // Breaks ties between the best replies, like the computer does when it
+    // searches itself.
+    std::mt19937 rng;
+    QHash<quint64, Move> replies;
+};
+
+}
+
+#endif // PONDER_H
@@ -0,0 +1,209 @@
+#include "simulwindow.h"
+#include "ai.h"
+#include "trace.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QtConcurrent>
+#include <QtMath>
+
+// 60 frames per second.
+constexpr int kFrameIntervalMs = 16;
+// A finished game stays on screen for a second.
+constexpr int kGameOverFrames = 60;
+constexpr int kTileMarginInPx = 4;
+constexpr int kTilePenScaleFactor = 10;
+constexpr int kGameOverAlpha = 70;
+// The searches get no random generator and always play the first of the best
+// moves, so the first moves are random to make the games differ.
+constexpr int kSimulRandomPlies = 2;
+// Searches on the large boards are cut short to keep the games moving.
+constexpr int kSimulSearchDepth = 8;
+constexpr int kSimulMoveTimeMs = 250;
+
+namespace {
+
+template <typename BoardType>
+Move FindMove(SideToMove side, BoardType board, const std::atomic<bool>* stop, bool is_classic) {
+    if (board.NumPieces() < kSimulRandomPlies) {
+        std::mt19937 rng(std::random_device()());
+        return ai::GetRandomeMove(board, &rng);
+    }
+    ai::EngineConfig config;
+    config.algorithm = AiAlgorithm::kMinimax;
+    if (!is_classic) {
+        config.depth = kSimulSearchDepth;
+        config.max_time_ms = kSimulMoveTimeMs;
+    }
+    TranspositionTable table;
+    ai::SearchContext context;
+    context.table = &table;
+    context.stop = stop;
+    return ai::GetEngineMove(side, board, config, &context);
+}
+
+// Runs on the thread pool, with its own copy of the position.
+Move FindSimulMove(const GameState& game_state, const std::atomic<bool>* stop) {
+    TRACE_SCOPE("engine", "FindSimulMove");
+    switch (game_state.GetVariant()) {
+    case GameVariant::kQubic:
+        return FindMove(game_state.GetSideToMove(), game_state.GetQubicBoard(), stop, false);
+    case GameVariant::kUltimate:
+        return FindMove(game_state.GetSideToMove(), game_state.GetUltimateBoard(), stop, false);
+    default:
+        return FindMove(game_state.GetSideToMove(), game_state.GetBoard(), stop, true);
+    }
+}
+
+}
+
+SimulWindow::SimulWindow(int num_games, GameVariant variant_, QWidget *parent) :
+    QWidget(parent),
+    tiles(num_games),
+    num_tile_cols(qCeil(qSqrt(num_games))),
+    tile_size_in_px(0),
+    is_closing(false),
+    num_x_wins(0),
+    num_o_wins(0),
+    num_draws(0)
+{
+    for (auto& tile : tiles) {
+        tile.game_state.SetVariant(variant_);
+    }
+    UpdateTitle();
+    connect(&frame_timer, SIGNAL(timeout()), this, SLOT(on_frame_timer_timeout()));
+    frame_timer.setTimerType(Qt::PreciseTimer);
+    frame_timer.start(kFrameIntervalMs);
+}
+
+SimulWindow::~SimulWindow() {
+    frame_timer.stop();
+    is_closing = true;
+    thread_pool.waitForDone();
+}
+
+void SimulWindow::on_frame_timer_timeout() {
+    TRACE_SCOPE("ui", "SimulWindow::on_frame_timer_timeout");
+    for (int i = 0; i < tiles.size(); ++i) {
+        Tile& tile = tiles[i];
+        if (tile.is_move_pending && tile.move.isFinished()) {
+            tile.is_move_pending = false;
+            tile.game_state.MakeMove(tile.move.result());
+            tile.is_dirty = true;
+            if (tile.game_state.IsGameFinished()) {
+                FinishGame(tile);
+            }
+        } else if (tile.game_over_frames > 0 && --tile.game_over_frames == 0) {
+            tile.game_state.Reset();
+            tile.is_dirty = true;
+        }
+        if (!tile.is_move_pending && tile.game_over_frames == 0) {
+            ScheduleMove(tile);
+        }
+        if (tile.is_dirty) {
+            RenderTile(tile);
+            update(GetTileRect(i));
+        }
+    }
+}
+
+void SimulWindow::ScheduleMove(Tile& tile) {
+    tile.is_move_pending = true;
+    const std::atomic<bool>* stop = &is_closing;
+    GameState game_state = tile.game_state;
+    tile.move = QtConcurrent::run(&thread_pool, [game_state, stop]() {
+        return FindSimulMove(game_state, stop);
+    });
+}
+
+void SimulWindow::FinishGame(Tile& tile) {
+    GameStatus status = tile.game_state.GetGameStatus();
+    if (status == GameStatus::XWon) {
+        ++num_x_wins;
+    } else if (status == GameStatus::OWon) {
+        ++num_o_wins;
+    } else {
+        ++num_draws;
+    }
+    tile.game_over_frames = kGameOverFrames;
+    UpdateTitle();
+}
+
+void SimulWindow::RenderTile(Tile& tile) {
+    TRACE_SCOPE("ui", "SimulWindow::RenderTile");
+    tile.is_dirty = false;
+    if (tile_size_in_px <= 0) {
+        return;
+    }
+    tile.pixmap = QPixmap(tile_size_in_px, tile_size_in_px);
+    tile.pixmap.fill(Qt::white);
+    QPainter painter(&tile.pixmap);
+    const GameState& game_state = tile.game_state;
+    int num_rows = game_state.NumRows();
+    int num_cols = game_state.NumCols();
+    int square_size = (tile_size_in_px - 2 * kTileMarginInPx) / qMax(num_rows, num_cols);
+    int offset_x = (tile_size_in_px - square_size * num_cols) / 2;
+    int offset_y = (tile_size_in_px - square_size * num_rows) / 2;
+    int pen_width = qMax(1, square_size / kTilePenScaleFactor);
+    if (tile.game_over_frames > 0) {
+        QColor color = (game_state.GetGameStatus() == GameStatus::XWon) ? QColor(Qt::red) :
+                       (game_state.GetGameStatus() == GameStatus::OWon) ? QColor(Qt::green) :
+                                                                          QColor(Qt::gray);
+        color.setAlpha(kGameOverAlpha);
+        painter.fillRect(tile.pixmap.rect(), color);
+    }
+    QPen pen;
+    pen.setWidth(pen_width);
+    for (int row = 0; row < num_rows; ++row) {
+        for (int col = 0; col < num_cols; ++col) {
+            QRect rect(offset_x + col * square_size, offset_y + row * square_size,
+                       square_size, square_size);
+            painter.setPen(Qt::black);
+            painter.drawRect(rect);
+            Piece piece = game_state.PieceAt(row, col);
+            if (piece == Piece::X) {
+                pen.setColor(Qt::red);
+                painter.setPen(pen);
+                QRect inner = rect.adjusted(pen_width, pen_width, -pen_width, -pen_width);
+                painter.drawLine(inner.topLeft(), inner.bottomRight());
+                painter.drawLine(inner.topRight(), inner.bottomLeft());
+            } else if (piece == Piece::O) {
+                pen.setColor(Qt::green);
+                painter.setPen(pen);
+                painter.drawEllipse(rect.adjusted(pen_width, pen_width, -pen_width, -pen_width));
+            }
+        }
+    }
+}
+
+QRect SimulWindow::GetTileRect(int index) const {
+    return QRect(index % num_tile_cols * tile_size_in_px, index / num_tile_cols * tile_size_in_px,
+                 tile_size_in_px, tile_size_in_px);
+}
+
+void SimulWindow::UpdateTitle() {
+    setWindowTitle(tr("Simul: %1 games, X won %2, O won %3, drawn %4")
+                   .arg(tiles.size()).arg(num_x_wins).arg(num_o_wins).arg(num_draws));
+}
+
+void SimulWindow::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("ui", "SimulWindow::paintEvent");
+    QPainter painter(this);
+    // Only the tiles in the exposed region are drawn, each with one blit.
+    for (int i = 0; i < tiles.size(); ++i) {
+        QRect rect = GetTileRect(i);
+        if (event->rect().intersects(rect) && !tiles[i].pixmap.isNull()) {
+            painter.drawPixmap(rect.topLeft(), tiles[i].pixmap);
+        }
+    }
+}
+
+void SimulWindow::resizeEvent(QResizeEvent *event) {
+    int num_tile_rows = (tiles.size() + num_tile_cols - 1) / num_tile_cols;
+    tile_size_in_px = qMin(event->size().width() / num_tile_cols,
+                           event->size().height() / num_tile_rows);
+    for (auto& tile : tiles) {
+        RenderTile(tile);
+    }
+    QWidget::resizeEvent(event);
+}
@@ -0,0 +1,64 @@
+#ifndef SIMULWINDOW_H
+#define SIMULWINDOW_H
+
+#include "gamestate.h"
+#include <QWidget>
+#include <QTimer>
+#include <QThreadPool>
+#include <QFuture>
+#include <QPixmap>
+#include <QVector>
+#include <atomic>
+
+// A window with a grid of games that the computer plays against itself, all
+// at once, for demos and load tests.
+//
+// Every tile keeps its own rendering in a pixmap. A frame timer collects the
+// moves the thread pool has found, redraws the pixmaps of the tiles whose
+// game changed and repaints only those tiles, so the cost of a frame depends
+// on the number of moves made, not on the number of games.
+class SimulWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SimulWindow(int num_games, GameVariant variant_, QWidget *parent = 0);
+    ~SimulWindow();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+
+private slots:
+    void on_frame_timer_timeout();
+
+private:
+    struct Tile {
+        Tile() : is_dirty(true), is_move_pending(false), game_over_frames(0) {}
+        GameState game_state;
+        QPixmap pixmap;
+        bool is_dirty;
+        bool is_move_pending;
+        QFuture<Move> move;
+        // Frames left to show a finished game before the next one starts.
+        int game_over_frames;
+    };
+    void ScheduleMove(Tile& tile);
+    void FinishGame(Tile& tile);
+    void RenderTile(Tile& tile);
+    QRect GetTileRect(int index) const;
+    void UpdateTitle();
+
+    QVector<Tile> tiles;
+    int num_tile_cols;
+    int tile_size_in_px;
+    QTimer frame_timer;
+    QThreadPool thread_pool;
+    // Aborts the searches still running when the window closes.
+    std::atomic<bool> is_closing;
+    int num_x_wins;
+    int num_o_wins;
+    int num_draws;
+};
+
+#endif // SIMULWINDOW_H
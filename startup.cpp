@@ -0,0 +1,41 @@
+#include "startup.h"
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace startup {
+
+namespace {
+
+QElapsedTimer timer;
+qint64 first_paint_ms = -1;
+qint64 engine_ready_ms = -1;
+
+void Report() {
+    if (first_paint_ms < 0 || engine_ready_ms < 0 || qEnvironmentVariableIsEmpty("TICTACTOE_STARTUP_TIME")) {
+        return;
+    }
+    qDebug() << "Startup: first paint after" << first_paint_ms << "ms, engine ready after"
+             << engine_ready_ms << "ms";
+}
+
+}
+
+void Start() {
+    timer.start();
+}
+
+void MarkFirstPaint() {
+    if (first_paint_ms < 0 && timer.isValid()) {
+        first_paint_ms = timer.elapsed();
+        Report();
+    }
+}
+
+void MarkEngineReady() {
+    if (engine_ready_ms < 0 && timer.isValid()) {
+        engine_ready_ms = timer.elapsed();
+        Report();
+    }
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+// Startup timing: how long after the start of main() the first frame is
+// painted and the engine is ready to play. With TICTACTOE_STARTUP_TIME set,
+// both times are printed once the second of them is known.
+namespace startup {
+
+// Called first thing in main().
+void Start();
+// The first call of each records the time, later calls do nothing. UI thread
+// only.
+void MarkFirstPaint();
+void MarkEngineReady();
+
+}
+
+#endif // STARTUP_H
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Unit tests of the game state. Run them with make check.
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+TARGET = tst_gamestate
+TEMPLATE = app
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+include(../../engine/engine.pri)
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+        tst_gamestate.cpp \
+        ../../gamestate.cpp
+
+HEADERS += \
+        ../../gamestate.h
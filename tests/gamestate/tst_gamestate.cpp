@@ -0,0 +1,141 @@
+#include "gamestate.h"
+#include <QtTest>
+
+namespace {
+
+// A game of the classic board that nobody wins in its first six moves.
+const Move kMoves[] = {Move(0, 0), Move(1, 1), Move(0, 1), Move(0, 2), Move(2, 0), Move(1, 0)};
+
+void PlayMoves(GameState* game_state, int num_moves) {
+    for (int i = 0; i < num_moves; ++i) {
+        game_state->MakeMove(kMoves[i]);
+    }
+}
+
+} // namespace
+
+class TestGameState : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void PlayerToMoveFollowsComputerMode();
+    void ComputerModeReplacesPreviousOne();
+    void UndoTurnWhenComputerPlaysX();
+    void UndoTurnWhenComputerPlaysO();
+    void UndoTurnWhenComputerObserves();
+    void RedoTurnWhenComputerPlaysX();
+    void RedoTurnWhenComputerPlaysO();
+    void RedoTurnWhenComputerObserves();
+    void UndoTurnAtStartOfGame();
+};
+
+void TestGameState::PlayerToMoveFollowsComputerMode() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kPlaysX);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Computer);
+    game_state.MakeMove(kMoves[0]);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Human);
+    game_state.SetComputerMode(ComputerMode::kPlaysO);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Computer);
+    game_state.SetComputerMode(ComputerMode::kObserves);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Human);
+}
+
+void TestGameState::ComputerModeReplacesPreviousOne() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kPlaysO);
+    game_state.SetComputerMode(ComputerMode::kPlaysX);
+    QVERIFY(game_state.GetPlayerX() == Player::Computer);
+    QVERIFY(game_state.GetPlayerO() == Player::Human);
+    game_state.SetComputerMode(ComputerMode::kPlaysO);
+    QVERIFY(game_state.GetPlayerX() == Player::Human);
+    QVERIFY(game_state.GetPlayerO() == Player::Computer);
+}
+
+void TestGameState::UndoTurnWhenComputerPlaysX() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kPlaysX);
+    PlayMoves(&game_state, 5);
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 3);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Human);
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 1);
+    // Only the first move of the computer is left, which nobody answered.
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 0);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Computer);
+}
+
+void TestGameState::UndoTurnWhenComputerPlaysO() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kPlaysO);
+    PlayMoves(&game_state, 4);
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 2);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Human);
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 0);
+    QVERIFY(!game_state.UndoTurn());
+}
+
+void TestGameState::UndoTurnWhenComputerObserves() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kObserves);
+    PlayMoves(&game_state, 4);
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 3);
+    QVERIFY(game_state.UndoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 2);
+}
+
+void TestGameState::RedoTurnWhenComputerPlaysX() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kPlaysX);
+    PlayMoves(&game_state, 5);
+    game_state.UndoTurn();
+    game_state.UndoTurn();
+    QVERIFY(game_state.RedoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 3);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Human);
+    QVERIFY(game_state.RedoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 5);
+    QVERIFY(!game_state.RedoTurn());
+}
+
+void TestGameState::RedoTurnWhenComputerPlaysO() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kPlaysO);
+    PlayMoves(&game_state, 4);
+    game_state.UndoTurn();
+    game_state.UndoTurn();
+    QVERIFY(game_state.RedoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 2);
+    QVERIFY(game_state.GetPlayerToMove() == Player::Human);
+    QVERIFY(game_state.RedoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 4);
+}
+
+void TestGameState::RedoTurnWhenComputerObserves() {
+    GameState game_state;
+    game_state.SetComputerMode(ComputerMode::kObserves);
+    PlayMoves(&game_state, 4);
+    game_state.UndoTurn();
+    game_state.UndoTurn();
+    QVERIFY(game_state.RedoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 3);
+    QVERIFY(game_state.RedoTurn());
+    QCOMPARE(game_state.GetMoveHistory().size(), 4);
+}
+
+void TestGameState::UndoTurnAtStartOfGame() {
+    GameState game_state;
+    QVERIFY(!game_state.CanUndo());
+    QVERIFY(!game_state.UndoTurn());
+    QVERIFY(!game_state.RedoTurn());
+}
+
+QTEST_APPLESS_MAIN(TestGameState)
+
+#include "tst_gamestate.moc"
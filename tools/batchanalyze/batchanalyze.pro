@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Streaming batch position analysis.
+#
+#-------------------------------------------------
+
+TARGET = batchanalyze
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    pipeline.h
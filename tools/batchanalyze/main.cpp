@@ -0,0 +1,289 @@
+// Scores a stream of positions with proof-number search and writes one
+// record per position, in input order.
+//
+// Usage: batchanalyze [--rows R] [--cols C] [--k K] [--format text|binary]
+//                     [--threads N] [--tt-mb MB] [--max-nodes N]
+//                     [--queue N] [--encode] [FILE]
+//
+// Positions are read from FILE, or from stdin without it. A text position is
+// a line of NumSquares() characters 'x', 'o' and '.' in row-major order. A
+// binary position packs 2 bits per square (0 - empty, 1 - X, 2 - O, the first
+// square in the low bits of the first byte) into (2 * NumSquares() + 7) / 8
+// bytes. X moves first, so the side to move follows from the piece counts, and
+// a position with more O's than X's or with two more X's is invalid.
+// --encode converts text positions to binary ones instead of scoring them.
+//
+// Every output line is "position value row,col nodes", where value is win,
+// draw, loss or unknown for the side to move and row,col is its best move, or
+// "none" if the game is already over. An invalid position gives
+// "position invalid".
+//
+// A reader thread feeds a bounded queue, the workers each own a solver with a
+// fixed-size table, and results wait in a bounded reorder window until all
+// earlier ones are written, so memory use does not grow with the input.
+
+#include "board.h"
+#include "dfpn.h"
+#include "pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int kDefaultTableSizeInMb = 32;
+// Positions queued per worker, and results each worker may finish ahead of
+// the output.
+constexpr int kDefaultQueueDepth = 64;
+
+enum class InputFormat {
+    kText,
+    kBinary
+};
+
+struct BatchOptions {
+    int num_rows = kNumRows;
+    int num_cols = kNumCols;
+    int win_length = kWinLength;
+    InputFormat format = InputFormat::kText;
+    int num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int table_size_in_mb = kDefaultTableSizeInMb;
+    uint64_t max_nodes = 0;
+    int queue_depth = kDefaultQueueDepth;
+    bool is_encoding = false;
+    std::string input_path;
+};
+
+struct Job {
+    uint64_t index;
+    // A text line or a binary record, decoded by the worker.
+    std::string record;
+};
+
+struct Result {
+    Result() : is_end(false) {}
+    // Marks the end of the input, one past the last position.
+    bool is_end;
+    std::string line;
+};
+
+bool ParseOptions(int argc, char *argv[], BatchOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--", 2) != 0) {
+            options->input_path = argv[i];
+            continue;
+        }
+        if (std::strcmp(argv[i], "--encode") == 0) {
+            options->is_encoding = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[i + 1];
+        if (std::strcmp(argv[i], "--rows") == 0) {
+            options->num_rows = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--cols") == 0) {
+            options->num_cols = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--k") == 0) {
+            options->win_length = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--format") == 0 && std::strcmp(value, "text") == 0) {
+            options->format = InputFormat::kText;
+        } else if (std::strcmp(argv[i], "--format") == 0 && std::strcmp(value, "binary") == 0) {
+            options->format = InputFormat::kBinary;
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            options->num_threads = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--tt-mb") == 0) {
+            options->table_size_in_mb = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--max-nodes") == 0) {
+            options->max_nodes = std::strtoull(value, nullptr, 10);
+        } else if (std::strcmp(argv[i], "--queue") == 0) {
+            options->queue_depth = std::atoi(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options->num_rows > 0 && options->num_rows <= kMaxBoardSize &&
+            options->num_cols > 0 && options->num_cols <= kMaxBoardSize &&
+            options->win_length > 0 && options->win_length <= kMaxWinLength &&
+            options->win_length <= std::max(options->num_rows, options->num_cols) &&
+            options->num_threads > 0 && options->table_size_in_mb > 0 &&
+            options->queue_depth > 0;
+}
+
+int BinaryRecordSize(int num_squares) {
+    return (2 * num_squares + 7) / 8;
+}
+
+// Returns an empty string for an invalid record.
+std::string DecodeBinary(const std::string& record, int num_squares) {
+    const char kSquareChars[] = {'.', 'x', 'o'};
+    std::string text(num_squares, '.');
+    for (int square = 0; square < num_squares; ++square) {
+        int code = (static_cast<unsigned char>(record[square / 4]) >> (2 * (square % 4))) & 3;
+        if (code == 3) {
+            return std::string();
+        }
+        text[square] = kSquareChars[code];
+    }
+    return text;
+}
+
+// Returns an empty string for an invalid position.
+std::string EncodeBinary(const std::string& text, int num_squares) {
+    if (static_cast<int>(text.size()) != num_squares) {
+        return std::string();
+    }
+    std::string record(BinaryRecordSize(num_squares), '\0');
+    for (int square = 0; square < num_squares; ++square) {
+        int code = (text[square] == 'x' || text[square] == 'X') ? 1 :
+                   (text[square] == 'o' || text[square] == 'O') ? 2 : (text[square] == '.') ? 0 : 3;
+        if (code == 3) {
+            return std::string();
+        }
+        record[square / 4] |= static_cast<char>(code << (2 * (square % 4)));
+    }
+    return record;
+}
+
+// Reads the next position, stripping the line ending of text ones and
+// skipping empty lines. Returns false at the end of the input.
+bool ReadRecord(std::istream& input, InputFormat format, int num_squares, std::string* record) {
+    if (format == InputFormat::kBinary) {
+        record->resize(BinaryRecordSize(num_squares));
+        return static_cast<bool>(input.read(&(*record)[0], record->size()));
+    }
+    while (std::getline(input, *record)) {
+        if (!record->empty() && record->back() == '\r') {
+            record->pop_back();
+        }
+        if (!record->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GameValueName(ai::GameValue value) {
+    switch (value) {
+    case ai::GameValue::kWin:
+        return "win";
+    case ai::GameValue::kDraw:
+        return "draw";
+    case ai::GameValue::kLoss:
+        return "loss";
+    default:
+        return "unknown";
+    }
+}
+
+std::string AnalyzePosition(ai::DfpnSolver& solver, const BatchOptions& options,
+                            const std::string& record) {
+    Board board(options.num_rows, options.num_cols, options.win_length);
+    std::string text = (options.format == InputFormat::kBinary) ?
+                DecodeBinary(record, board.NumSquares()) : record;
+    if (text.empty() || !board.FromString(text)) {
+        return (options.format == InputFormat::kBinary ? std::string("?") : record) + " invalid";
+    }
+    int num_x = 0;
+    for (char square : text) {
+        num_x += (square == 'x' || square == 'X') ? 1 : 0;
+    }
+    int num_extra_x = 2 * num_x - board.NumPieces();
+    if (num_extra_x != 0 && num_extra_x != 1) {
+        return board.ToString() + " invalid";
+    }
+    SideToMove side = (num_extra_x == 0) ? SideToMove::X : SideToMove::O;
+    ai::SolveResult result = solver.Solve(side, board, options.max_nodes);
+    std::string best_move = board.IsTerminalNode() ? std::string("none") :
+            std::to_string(result.best_move.row) + "," + std::to_string(result.best_move.col);
+    return board.ToString() + " " + GameValueName(result.value) + " " + best_move + " " +
+            std::to_string(result.nodes);
+}
+
+int Encode(std::istream& input, const BatchOptions& options) {
+    int num_squares = options.num_rows * options.num_cols;
+    std::string line;
+    bool is_ok = true;
+    while (ReadRecord(input, InputFormat::kText, num_squares, &line)) {
+        std::string record = EncodeBinary(line, num_squares);
+        if (record.empty()) {
+            std::cerr << line << " invalid" << std::endl;
+            is_ok = false;
+            continue;
+        }
+        std::cout.write(record.data(), record.size());
+    }
+    return is_ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    std::ios::sync_with_stdio(false);
+    BatchOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        std::cerr << "Usage: batchanalyze [--rows R] [--cols C] [--k K] [--format text|binary]"
+                     " [--threads N] [--tt-mb MB] [--max-nodes N] [--queue N] [--encode] [FILE]"
+                  << std::endl;
+        return 1;
+    }
+    std::ifstream file;
+    if (!options.input_path.empty()) {
+        file.open(options.input_path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Could not open " << options.input_path << std::endl;
+            return 1;
+        }
+    }
+    std::istream& input = options.input_path.empty() ? std::cin : file;
+    if (options.is_encoding) {
+        return Encode(input, options);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int capacity = options.num_threads * options.queue_depth;
+    BoundedQueue<Job> jobs(capacity);
+    ReorderBuffer<Result> results(capacity);
+    std::thread reader([&]() {
+        uint64_t index = 0;
+        std::string record;
+        while (ReadRecord(input, options.format, options.num_rows * options.num_cols, &record)) {
+            jobs.Push(Job{index++, record});
+        }
+        jobs.Close();
+        Result end;
+        end.is_end = true;
+        results.Put(index, end);
+    });
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.num_threads; ++i) {
+        workers.emplace_back([&]() {
+            ai::DfpnSolver solver(options.table_size_in_mb);
+            Job job;
+            while (jobs.Pop(&job)) {
+                Result result;
+                result.line = AnalyzePosition(solver, options, job.record);
+                results.Put(job.index, result);
+            }
+        });
+    }
+    uint64_t num_positions = 0;
+    for (Result result = results.Take(); !result.is_end; result = results.Take()) {
+        std::cout << result.line << '\n';
+        ++num_positions;
+    }
+    std::cout.flush();
+    reader.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << num_positions << " positions in " << seconds << " s, "
+              << (seconds > 0 ? num_positions / seconds : 0) << " positions/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,86 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+
+// A FIFO queue of at most capacity items shared by threads. Push() blocks
+// while the queue is full and Pop() while it is empty, so a fast producer
+// waits for its consumers instead of buffering the whole input.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity_) : capacity(capacity_), is_closed(false) {}
+    void Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]() { return static_cast<int>(items.size()) < capacity; });
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+    }
+    // Returns false once the queue is closed and empty.
+    bool Pop(T* item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]() { return !items.empty() || is_closed; });
+        if (items.empty()) {
+            return false;
+        }
+        *item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+    // No more items will be pushed.
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_closed = true;
+        not_empty.notify_all();
+    }
+private:
+    const int capacity;
+    bool is_closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+// Puts results that are finished out of order back in input order. Put()
+// blocks while index is capacity or more ahead of the next result to be
+// taken, which bounds the results held at once. The worker holding the next
+// result never blocks, so this cannot deadlock as long as the inputs are
+// handed out in order.
+template <typename T>
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(int capacity_) : capacity(capacity_), next_index(0) {}
+    void Put(uint64_t index, T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        has_room.wait(lock, [this, index]() { return index < next_index + capacity; });
+        items.emplace(index, std::move(item));
+        if (index == next_index) {
+            has_next.notify_one();
+        }
+    }
+    // Blocks until the result with the next index arrives.
+    T Take() {
+        std::unique_lock<std::mutex> lock(mutex);
+        has_next.wait(lock, [this]() { return !items.empty() && items.begin()->first == next_index; });
+        T item = std::move(items.begin()->second);
+        items.erase(items.begin());
+        ++next_index;
+        has_room.notify_all();
+        return item;
+    }
+private:
+    const uint64_t capacity;
+    uint64_t next_index;
+    std::map<uint64_t, T> items;
+    std::mutex mutex;
+    std::condition_variable has_room;
+    std::condition_variable has_next;
+};
+
+#endif // PIPELINE_H
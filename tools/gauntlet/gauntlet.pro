@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# Headless engine-vs-engine match runner with SPRT.
+#
+#-------------------------------------------------
+
+TARGET = gauntlet
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+        main.cpp \
+    sprt.cpp
+
+HEADERS += \
+    sprt.h
@@ -0,0 +1,315 @@
+// Plays two engine configurations against each other and decides with a
+// sequential probability ratio test whether the first is stronger.
+//
+// Usage: gauntlet --engine-a SPEC --engine-b SPEC [--rows R] [--cols C] [--k K]
+//                 [--opening-plies N] [--max-pairs N] [--threads N] [--seed S]
+//                 [--elo0 E] [--elo1 E] [--alpha A] [--beta B] [--weights FILE]
+//
+// SPEC is "random" or "minimax" with optional limits, for example
+// "minimax:depth=6,nodes=20000,time=50" (time in milliseconds). candidates=1
+// searches only the squares near the pieces, see Board::GenCandidateMoves().
+// With --weights both engines score the positions where their search stops
+// with that n-tuple network, which must be made for the board size played.
+//
+// Every pair of games starts from the same random opening, once with each
+// engine playing X, and both games break ties with the same random seed. Pairs are played in parallel until the SPRT accepts one of
+// its hypotheses or --max-pairs is reached.
+
+#include "ai.h"
+#include "board.h"
+#include "ntuple.h"
+#include "sprt.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int kDefaultOpeningPlies = 2;
+constexpr int kDefaultMaxPairs = 10000;
+constexpr int kReportInterval = 500;
+// Random openings tried before a pair gives up on finding an undecided one.
+constexpr int kMaxOpeningAttempts = 10000;
+
+struct GauntletOptions {
+    ai::EngineConfig engine_a;
+    ai::EngineConfig engine_b;
+    std::string engine_a_spec;
+    std::string engine_b_spec;
+    int num_rows = kNumRows;
+    int num_cols = kNumCols;
+    int win_length = kWinLength;
+    int opening_plies = kDefaultOpeningPlies;
+    int max_pairs = kDefaultMaxPairs;
+    int num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    unsigned seed = 1;
+    double elo0 = 0.0;
+    double elo1 = 10.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+    std::string weights_path;
+};
+
+bool ParseEngineSpec(const std::string& spec, ai::EngineConfig* config) {
+    std::string name = spec.substr(0, spec.find(':'));
+    if (name == "random") {
+        config->algorithm = AiAlgorithm::kRandom;
+        return spec == name;
+    } else if (name != "minimax") {
+        return false;
+    }
+    config->algorithm = AiAlgorithm::kMinimax;
+    size_t pos = name.size();
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos + 1);
+        std::string limit = spec.substr(pos + 1, end == std::string::npos ? std::string::npos :
+                                                                            end - pos - 1);
+        size_t eq = limit.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        std::string key = limit.substr(0, eq);
+        long long value = std::atoll(limit.c_str() + eq + 1);
+        if (value < 0) {
+            return false;
+        }
+        if (key == "depth") {
+            config->depth = static_cast<int>(value);
+        } else if (key == "nodes") {
+            config->max_nodes = static_cast<uint64_t>(value);
+        } else if (key == "time") {
+            config->max_time_ms = static_cast<int>(value);
+        } else if (key == "candidates") {
+            config->use_candidate_moves = (value != 0);
+        } else {
+            return false;
+        }
+        pos = (end == std::string::npos) ? spec.size() : end;
+    }
+    return config->depth > 0;
+}
+
+bool ParseOptions(int argc, char *argv[], GauntletOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[i + 1];
+        if (std::strcmp(argv[i], "--engine-a") == 0) {
+            options->engine_a_spec = value;
+        } else if (std::strcmp(argv[i], "--engine-b") == 0) {
+            options->engine_b_spec = value;
+        } else if (std::strcmp(argv[i], "--rows") == 0) {
+            options->num_rows = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--cols") == 0) {
+            options->num_cols = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--k") == 0) {
+            options->win_length = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--opening-plies") == 0) {
+            options->opening_plies = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--max-pairs") == 0) {
+            options->max_pairs = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            options->num_threads = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options->seed = static_cast<unsigned>(std::atoi(value));
+        } else if (std::strcmp(argv[i], "--elo0") == 0) {
+            options->elo0 = std::atof(value);
+        } else if (std::strcmp(argv[i], "--elo1") == 0) {
+            options->elo1 = std::atof(value);
+        } else if (std::strcmp(argv[i], "--alpha") == 0) {
+            options->alpha = std::atof(value);
+        } else if (std::strcmp(argv[i], "--beta") == 0) {
+            options->beta = std::atof(value);
+        } else if (std::strcmp(argv[i], "--weights") == 0) {
+            options->weights_path = value;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return ParseEngineSpec(options->engine_a_spec, &options->engine_a) &&
+            ParseEngineSpec(options->engine_b_spec, &options->engine_b) &&
+            options->num_rows > 0 && options->num_rows <= kMaxBoardSize &&
+            options->num_cols > 0 && options->num_cols <= kMaxBoardSize &&
+            options->win_length > 0 && options->win_length <= kMaxWinLength &&
+            options->win_length <= std::max(options->num_rows, options->num_cols) &&
+            options->opening_plies >= 0 &&
+            options->opening_plies < options->num_rows * options->num_cols &&
+            options->max_pairs > 0 && options->num_threads > 0 &&
+            options->elo0 < options->elo1 &&
+            options->alpha > 0.0 && options->alpha < 1.0 && options->beta > 0.0 && options->beta < 1.0;
+}
+
+// Random opening which is not yet decided. Side to move follows from the
+// number of plies. Returns false if none turned up in kMaxOpeningAttempts.
+bool MakeOpening(const GauntletOptions& options, std::mt19937& gen, Board* opening) {
+    Board board(options.num_rows, options.num_cols, options.win_length);
+    for (int attempt = 0; attempt < kMaxOpeningAttempts; ++attempt) {
+        board.Reset();
+        Piece piece = Piece::X;
+        for (int ply = 0; ply < options.opening_plies && !board.IsTerminalNode(); ++ply) {
+            std::vector<Move> valid_moves = board.GenValidMoves();
+            board.MakeMove(valid_moves[gen() % valid_moves.size()], piece);
+            piece = (piece == Piece::X) ? Piece::O : Piece::X;
+        }
+        if (!board.IsTerminalNode()) {
+            *opening = board;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Plays a game from the opening and returns X's score. Each engine keeps its
+// own transposition table for the whole game, and random choices of both come
+// from seed.
+double PlayGame(const ai::EngineConfig& engine_x, const ai::EngineConfig& engine_o,
+                Board board, unsigned seed, uint64_t* nodes) {
+    TranspositionTable table_x;
+    TranspositionTable table_o;
+    std::mt19937 rng(seed);
+    SideToMove side = (board.NumPieces() % 2 == 0) ? SideToMove::X : SideToMove::O;
+    while (!board.IsTerminalNode()) {
+        ai::SearchContext context;
+        context.table = (side == SideToMove::X) ? &table_x : &table_o;
+        context.rng = &rng;
+        Move move = ai::GetEngineMove(side, board, (side == SideToMove::X) ? engine_x : engine_o,
+                                      &context);
+        *nodes += context.nodes;
+        board.MakeMove(move, (side == SideToMove::X) ? Piece::X : Piece::O);
+        side = (side == SideToMove::X) ? SideToMove::O : SideToMove::X;
+    }
+    if (board.CheckWin(Piece::X)) {
+        return 1.0;
+    } else if (board.CheckWin(Piece::O)) {
+        return 0.0;
+    }
+    return 0.5;
+}
+
+struct MatchState {
+    explicit MatchState(const GauntletOptions& options) :
+        sprt(options.elo0, options.elo1, options.alpha, options.beta),
+        next_pair(0), is_finished(false), has_failed(false), wins(0), draws(0), losses(0),
+        nodes(0) {}
+    std::mutex mutex;
+    Sprt sprt;
+    std::atomic<int> next_pair;
+    std::atomic<bool> is_finished;
+    // Set when a worker could not make an opening.
+    std::atomic<bool> has_failed;
+    int wins;
+    int draws;
+    int losses;
+    uint64_t nodes;
+};
+
+void PrintReport(const MatchState& state, double seconds) {
+    const Sprt& sprt = state.sprt;
+    const int* penta = sprt.GetPentanomial();
+    int games = 2 * sprt.NumPairs();
+    std::cout << "pairs " << sprt.NumPairs()
+              << "  A: +" << state.wins << " =" << state.draws << " -" << state.losses
+              << "  pentanomial [" << penta[0] << " " << penta[1] << " " << penta[2] << " "
+              << penta[3] << " " << penta[4] << "]"
+              << "  elo " << sprt.EloEstimate() << " +- " << sprt.EloErrorMargin()
+              << "  llr " << sprt.Llr() << " [" << sprt.LowerBound() << ", "
+              << sprt.UpperBound() << "]"
+              << "  games/s " << (seconds > 0 ? games / seconds : 0.0)
+              << "  nodes/s " << (seconds > 0 ? state.nodes / seconds : 0.0) << std::endl;
+}
+
+void RunWorker(const GauntletOptions& options, MatchState* state,
+               std::chrono::steady_clock::time_point start) {
+    while (!state->is_finished) {
+        int pair = state->next_pair++;
+        if (pair >= options.max_pairs) {
+            return;
+        }
+        std::mt19937 gen(options.seed * 1000003u + static_cast<unsigned>(pair));
+        Board opening;
+        if (!MakeOpening(options, gen, &opening)) {
+            state->has_failed = true;
+            state->is_finished = true;
+            return;
+        }
+        unsigned game_seed = gen();
+        uint64_t nodes = 0;
+        double first_score = PlayGame(options.engine_a, options.engine_b, opening, game_seed,
+                                      &nodes);
+        double second_score = 1.0 - PlayGame(options.engine_b, options.engine_a, opening,
+                                             game_seed, &nodes);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        for (double score : {first_score, second_score}) {
+            state->wins += (score == 1.0) ? 1 : 0;
+            state->draws += (score == 0.5) ? 1 : 0;
+            state->losses += (score == 0.0) ? 1 : 0;
+        }
+        state->nodes += nodes;
+        state->sprt.AddPair(first_score, second_score);
+        if (state->sprt.GetDecision() != Sprt::Decision::kContinue) {
+            state->is_finished = true;
+        }
+        if (state->sprt.NumPairs() % kReportInterval == 0) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            PrintReport(*state, elapsed.count());
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    GauntletOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        std::cerr << "Usage: gauntlet --engine-a SPEC --engine-b SPEC [--rows R] [--cols C] [--k K]"
+                     " [--opening-plies N] [--max-pairs N] [--threads N] [--seed S]"
+                     " [--elo0 E] [--elo1 E] [--alpha A] [--beta B] [--weights FILE]" << std::endl;
+        return 1;
+    }
+    // Boards take the default network when they are made, so it has to be
+    // loaded before the first opening.
+    if (!options.weights_path.empty() &&
+            (!ntuple::LoadDefaultNetwork(options.weights_path) ||
+             !ntuple::GetDefaultNetwork()->Matches(Board(options.num_rows, options.num_cols,
+                                                         options.win_length)))) {
+        std::cerr << "Could not load weights for this board size from " << options.weights_path
+                  << std::endl;
+        return 1;
+    }
+    MatchState state(options);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.num_threads; ++i) {
+        workers.emplace_back(RunWorker, std::cref(options), &state, start);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (state.has_failed) {
+        std::cerr << "No undecided opening of " << options.opening_plies << " plies found" << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "A = " << options.engine_a_spec << ", B = " << options.engine_b_spec << std::endl;
+    PrintReport(state, elapsed.count());
+    switch (state.sprt.GetDecision()) {
+    case Sprt::Decision::kAcceptH1:
+        std::cout << "H1 accepted: A is stronger by at least " << options.elo1 << " Elo" << std::endl;
+        break;
+    case Sprt::Decision::kAcceptH0:
+        std::cout << "H0 accepted: A is not stronger by more than " << options.elo0 << " Elo"
+                  << std::endl;
+        break;
+    default:
+        std::cout << "Inconclusive after " << options.max_pairs << " pairs" << std::endl;
+        break;
+    }
+    return 0;
+}
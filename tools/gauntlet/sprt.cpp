@@ -0,0 +1,119 @@
+#include "sprt.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Pairs added to every pentanomial bin when the log-likelihood ratio is
+// computed, so that a few equal pairs do not look like a zero variance.
+constexpr double kPriorPairsPerBin = 0.5;
+
+double EloToScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double ScoreToElo(double score) {
+    constexpr double kEpsilon = 1e-6;
+    score = std::max(kEpsilon, std::min(1.0 - kEpsilon, score));
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+}
+
+Sprt::Sprt(double elo0, double elo1, double alpha, double beta) :
+    score0(EloToScore(elo0)),
+    score1(EloToScore(elo1)),
+    lower_bound(std::log(beta / (1.0 - alpha))),
+    upper_bound(std::log((1.0 - beta) / alpha)),
+    num_pairs(0),
+    pentanomial{0, 0, 0, 0, 0}
+{
+
+}
+
+void Sprt::AddPair(double first_score, double second_score) {
+    int points = static_cast<int>(std::lround(2.0 * (first_score + second_score)));
+    ++pentanomial[std::max(0, std::min(4, points))];
+    ++num_pairs;
+}
+
+int Sprt::NumPairs() const {
+    return num_pairs;
+}
+
+const int* Sprt::GetPentanomial() const {
+    return pentanomial;
+}
+
+double Sprt::MeanScore(double prior_count) const {
+    double count = num_pairs + 5 * prior_count;
+    if (count == 0) {
+        return 0.5;
+    }
+    double sum = 0.0;
+    for (int i = 0; i < 5; ++i) {
+        sum += (pentanomial[i] + prior_count) * i / 4.0;
+    }
+    return sum / count;
+}
+
+double Sprt::PairScoreVariance(double prior_count) const {
+    double count = num_pairs + 5 * prior_count;
+    if (count == 0) {
+        return 0.0;
+    }
+    double mean = MeanScore(prior_count);
+    double sum = 0.0;
+    for (int i = 0; i < 5; ++i) {
+        double diff = i / 4.0 - mean;
+        sum += (pentanomial[i] + prior_count) * diff * diff;
+    }
+    return sum / count;
+}
+
+double Sprt::Llr() const {
+    // Normal approximation of the generalized SPRT log-likelihood ratio. The
+    // prior keeps the variance positive when every pair scored the same, as
+    // two deterministic engines do, so the ratio stays finite and such a
+    // match still ends.
+    if (num_pairs == 0) {
+        return 0.0;
+    }
+    double variance = PairScoreVariance(kPriorPairsPerBin);
+    return num_pairs * (score1 - score0) *
+            (2.0 * MeanScore(kPriorPairsPerBin) - score0 - score1) / (2.0 * variance);
+}
+
+double Sprt::LowerBound() const {
+    return lower_bound;
+}
+
+double Sprt::UpperBound() const {
+    return upper_bound;
+}
+
+Sprt::Decision Sprt::GetDecision() const {
+    if (num_pairs < kMinSprtPairs) {
+        return Decision::kContinue;
+    }
+    double llr = Llr();
+    if (llr <= lower_bound) {
+        return Decision::kAcceptH0;
+    } else if (llr >= upper_bound) {
+        return Decision::kAcceptH1;
+    }
+    return Decision::kContinue;
+}
+
+double Sprt::EloEstimate() const {
+    return ScoreToElo(MeanScore(0.0));
+}
+
+double Sprt::EloErrorMargin() const {
+    if (num_pairs == 0) {
+        return 0.0;
+    }
+    double mean = MeanScore(0.0);
+    double deviation = 1.96 * std::sqrt(PairScoreVariance(0.0) / num_pairs);
+    return (ScoreToElo(mean + deviation) - ScoreToElo(mean - deviation)) / 2.0;
+}
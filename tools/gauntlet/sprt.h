@@ -0,0 +1,50 @@
+#ifndef SPRT_H
+#define SPRT_H
+
+// Sequential probability ratio test on the Elo difference between two engines
+// which play game pairs from the same opening with colours reversed. Scores
+// are counted per pair (pentanomial model), which accounts for the correlation
+// between the two games of a pair.
+
+// Fewer pairs say too little about the variance to stop on.
+constexpr int kMinSprtPairs = 20;
+
+class Sprt {
+public:
+    enum class Decision {
+        kContinue,
+        // The difference is at most elo0.
+        kAcceptH0,
+        // The difference is at least elo1.
+        kAcceptH1
+    };
+
+    Sprt(double elo0, double elo1, double alpha, double beta);
+    // Scores of the first engine in the two games of a pair: 1, 0.5 or 0.
+    void AddPair(double first_score, double second_score);
+    int NumPairs() const;
+    // Number of pairs where the first engine scored 0, 0.5, 1, 1.5 and 2 points.
+    const int* GetPentanomial() const;
+    double Llr() const;
+    double LowerBound() const;
+    double UpperBound() const;
+    // Always kContinue before kMinSprtPairs pairs.
+    Decision GetDecision() const;
+    double EloEstimate() const;
+    // Half-width of the 95% confidence interval of EloEstimate().
+    double EloErrorMargin() const;
+private:
+    // Per-pair statistics, with prior_count made-up pairs added to every
+    // pentanomial bin.
+    double MeanScore(double prior_count) const;
+    double PairScoreVariance(double prior_count) const;
+
+    double score0;
+    double score1;
+    double lower_bound;
+    double upper_bound;
+    int num_pairs;
+    int pentanomial[5];
+};
+
+#endif // SPRT_H
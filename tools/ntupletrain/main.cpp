@@ -0,0 +1,165 @@
+// Trains the n-tuple evaluation by temporal-difference learning on self-play
+// games and writes the weights to a binary file which the game loads on start.
+//
+// Usage: ntupletrain [--rows R] [--cols C] [--k K] [--games N] [--alpha A]
+//                    [--epsilon E] [--seed S] [--in weights] [--out weights]
+
+#include "board.h"
+#include "ntuple.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr int kDefaultNumGames = 200000;
+constexpr float kDefaultAlpha = 0.01f;
+constexpr double kDefaultEpsilon = 0.1;
+constexpr int kReportInterval = 20000;
+
+struct TrainingOptions {
+    int num_rows = kNumRows;
+    int num_cols = kNumCols;
+    int win_length = kWinLength;
+    int num_games = kDefaultNumGames;
+    float alpha = kDefaultAlpha;
+    double epsilon = kDefaultEpsilon;
+    unsigned seed = 1;
+    std::string in_path;
+    std::string out_path = "ntuple.weights";
+};
+
+bool ParseOptions(int argc, char *argv[], TrainingOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[i + 1];
+        if (std::strcmp(argv[i], "--rows") == 0) {
+            options->num_rows = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--cols") == 0) {
+            options->num_cols = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--k") == 0) {
+            options->win_length = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--games") == 0) {
+            options->num_games = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--alpha") == 0) {
+            options->alpha = static_cast<float>(std::atof(value));
+        } else if (std::strcmp(argv[i], "--epsilon") == 0) {
+            options->epsilon = std::atof(value);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options->seed = static_cast<unsigned>(std::atoi(value));
+        } else if (std::strcmp(argv[i], "--in") == 0) {
+            options->in_path = value;
+        } else if (std::strcmp(argv[i], "--out") == 0) {
+            options->out_path = value;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options->num_games > 0 &&
+            options->num_rows > 0 && options->num_rows <= kMaxBoardSize &&
+            options->num_cols > 0 && options->num_cols <= kMaxBoardSize &&
+            options->win_length > 0 && options->win_length <= kMaxWinLength &&
+            options->win_length <= std::max(options->num_rows, options->num_cols);
+}
+
+// Game result from X's point of view, only valid for a finished game.
+float Reward(const Board& board) {
+    if (board.CheckWin(Piece::X)) {
+        return 1.0f;
+    } else if (board.CheckWin(Piece::O)) {
+        return -1.0f;
+    }
+    return 0.0f;
+}
+
+// Value of the position after a move, from X's point of view.
+float AfterstateValue(const ntuple::NTupleNetwork& network, const Board& board) {
+    return board.IsTerminalNode() ? Reward(board) : network.Evaluate(board);
+}
+
+// Plays one epsilon-greedy self-play game and applies a TD(0) update after every
+// move. Returns the result of the game from X's point of view.
+float PlayTrainingGame(ntuple::NTupleNetwork& network, const TrainingOptions& options,
+                       std::mt19937& gen) {
+    Board board(options.num_rows, options.num_cols, options.win_length);
+    Piece piece = Piece::X;
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    while (!board.IsTerminalNode()) {
+        std::vector<Move> valid_moves = board.GenValidMoves();
+        Move move;
+        if (coin(gen) < options.epsilon) {
+            move = valid_moves[gen() % valid_moves.size()];
+        } else {
+            float sign = (piece == Piece::X) ? 1.0f : -1.0f;
+            float best_value = 0.0f;
+            for (int i = 0; i < static_cast<int>(valid_moves.size()); ++i) {
+                board.MakeMove(valid_moves[i], piece);
+                float value = sign * AfterstateValue(network, board);
+                board.UnmakeMove(valid_moves[i]);
+                if (i == 0 || value > best_value) {
+                    best_value = value;
+                    move = valid_moves[i];
+                }
+            }
+        }
+        float value = network.Evaluate(board);
+        board.MakeMove(move, piece);
+        float target = AfterstateValue(network, board);
+        board.UnmakeMove(move);
+        network.Update(board, options.alpha * (target - value));
+        board.MakeMove(move, piece);
+        piece = (piece == Piece::X) ? Piece::O : Piece::X;
+    }
+    return Reward(board);
+}
+
+int main(int argc, char *argv[])
+{
+    TrainingOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        std::cerr << "Usage: ntupletrain [--rows R] [--cols C] [--k K] [--games N] [--alpha A]"
+                     " [--epsilon E] [--seed S] [--in weights] [--out weights]" << std::endl;
+        return 1;
+    }
+    ntuple::NTupleNetwork network(options.num_rows, options.num_cols, options.win_length);
+    if (!options.in_path.empty() && !network.Load(options.in_path)) {
+        std::cerr << "Failed to load weights from " << options.in_path << std::endl;
+        return 1;
+    }
+    if (!network.Matches(Board(options.num_rows, options.num_cols, options.win_length))) {
+        std::cerr << options.in_path << " was made for another board size" << std::endl;
+        return 1;
+    }
+    std::mt19937 gen(options.seed);
+    int x_wins = 0;
+    int o_wins = 0;
+    int draws = 0;
+    for (int game = 1; game <= options.num_games; ++game) {
+        float result = PlayTrainingGame(network, options, gen);
+        if (result > 0) {
+            ++x_wins;
+        } else if (result < 0) {
+            ++o_wins;
+        } else {
+            ++draws;
+        }
+        if (game % kReportInterval == 0 || game == options.num_games) {
+            std::cerr << "games " << game << " X won " << x_wins << " O won " << o_wins
+                      << " draws " << draws << " empty board value "
+                      << network.Evaluate(Board(options.num_rows, options.num_cols, options.win_length))
+                      << std::endl;
+            x_wins = o_wins = draws = 0;
+        }
+    }
+    if (!network.Save(options.out_path)) {
+        std::cerr << "Failed to save weights to " << options.out_path << std::endl;
+        return 1;
+    }
+    std::cerr << "Saved " << network.NumWeights() << " weights to " << options.out_path << std::endl;
+    return 0;
+}
@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Headless self-play trainer for the n-tuple evaluation.
+#
+#-------------------------------------------------
+
+TARGET = ntupletrain
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+        main.cpp
@@ -0,0 +1,165 @@
+// Solves positions with depth-first proof-number search and prints their
+// game-theoretic value for the side to move.
+//
+// Usage: pnsolver [--rows R] [--cols C] [--k K] [--tt-mb MB] [--max-nodes N]
+//                 [--cache FILE] [position...]
+//
+// Positions are NumSquares() characters of 'x', 'o' and '.' in row-major
+// order; X moves first, so the side to move follows from the piece counts.
+// A position of "-" reads positions from stdin, one per line. Without
+// positions the empty board is solved.
+//
+// With --cache every solved position is written to that persistent position
+// cache, where the engine finds it as an exact result.
+
+#include "board.h"
+#include "dfpn.h"
+#include "persistentcache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+constexpr int kDefaultTableSizeInMb = 256;
+constexpr int kDefaultCacheSizeInMb = 64;
+
+struct SolverOptions {
+    int num_rows = kNumRows;
+    int num_cols = kNumCols;
+    int win_length = kWinLength;
+    int table_size_in_mb = kDefaultTableSizeInMb;
+    uint64_t max_nodes = 0;
+    std::string cache_path;
+    std::vector<std::string> positions;
+};
+
+bool ParseOptions(int argc, char *argv[], SolverOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--", 2) != 0) {
+            options->positions.push_back(argv[i]);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[i + 1];
+        if (std::strcmp(argv[i], "--rows") == 0) {
+            options->num_rows = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--cols") == 0) {
+            options->num_cols = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--k") == 0) {
+            options->win_length = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--tt-mb") == 0) {
+            options->table_size_in_mb = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--max-nodes") == 0) {
+            options->max_nodes = std::strtoull(value, nullptr, 10);
+        } else if (std::strcmp(argv[i], "--cache") == 0) {
+            options->cache_path = value;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options->num_rows > 0 && options->num_rows <= kMaxBoardSize &&
+            options->num_cols > 0 && options->num_cols <= kMaxBoardSize &&
+            options->win_length > 0 && options->win_length <= kMaxWinLength &&
+            options->win_length <= std::max(options->num_rows, options->num_cols) &&
+            options->table_size_in_mb > 0;
+}
+
+const char* GameValueName(ai::GameValue value) {
+    switch (value) {
+    case ai::GameValue::kWin:
+        return "win";
+    case ai::GameValue::kDraw:
+        return "draw";
+    case ai::GameValue::kLoss:
+        return "loss";
+    default:
+        return "unknown";
+    }
+}
+
+int GameValueScore(ai::GameValue value) {
+    switch (value) {
+    case ai::GameValue::kWin:
+        return kWinEval;
+    case ai::GameValue::kLoss:
+        return -kWinEval;
+    default:
+        return kDrawEval;
+    }
+}
+
+bool SolvePosition(ai::DfpnSolver& solver, const SolverOptions& options, PersistentCache& cache,
+                   const std::string& text) {
+    Board board(options.num_rows, options.num_cols, options.win_length);
+    if (!board.FromString(text)) {
+        std::cout << text << " invalid" << std::endl;
+        return false;
+    }
+    int num_x = 0;
+    for (int square = 0; square < board.NumSquares(); ++square) {
+        if (board.At(square / board.NumCols(), square % board.NumCols()) == Piece::X) {
+            ++num_x;
+        }
+    }
+    SideToMove side = (2 * num_x == board.NumPieces()) ? SideToMove::X : SideToMove::O;
+    auto start = std::chrono::steady_clock::now();
+    ai::SolveResult result = solver.Solve(side, board, options.max_nodes);
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    std::cout << board.ToString()
+              << " value " << GameValueName(result.value)
+              << " move " << result.best_move.row << "," << result.best_move.col
+              << " nodes " << result.nodes
+              << " proof_size " << result.proof_size
+              << " peak_entries " << result.peak_entries
+              << " peak_memory_kb " << result.peak_memory_bytes / 1024
+              << " time_ms " << elapsed_ms << std::endl;
+    if (cache.IsOpen() && result.value != ai::GameValue::kUnknown) {
+        cache.Store(board.Hash(), TranspositionEntry(GameValueScore(result.value), kSolvedDepth,
+                                                     result.best_move));
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    SolverOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        std::cerr << "Usage: pnsolver [--rows R] [--cols C] [--k K] [--tt-mb MB] [--max-nodes N]"
+                     " [--cache FILE] [position...]" << std::endl;
+        return 1;
+    }
+    PersistentCache cache;
+    if (!options.cache_path.empty() &&
+            !cache.Open(options.cache_path, options.num_rows, options.num_cols, options.win_length,
+                        kDefaultCacheSizeInMb)) {
+        std::cerr << "Could not open the position cache " << options.cache_path << std::endl;
+        return 1;
+    }
+    ai::DfpnSolver solver(options.table_size_in_mb);
+    solver.SetCountProofSize(true);
+    bool is_ok = true;
+    if (options.positions.empty()) {
+        options.positions.push_back(Board(options.num_rows, options.num_cols,
+                                          options.win_length).ToString());
+    }
+    for (const std::string& position : options.positions) {
+        if (position != "-") {
+            is_ok = SolvePosition(solver, options, cache, position) && is_ok;
+            continue;
+        }
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty()) {
+                is_ok = SolvePosition(solver, options, cache, line) && is_ok;
+            }
+        }
+    }
+    return is_ok ? 0 : 1;
+}
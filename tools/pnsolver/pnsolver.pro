@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Batch proof-number search solver.
+#
+#-------------------------------------------------
+
+TARGET = pnsolver
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+        main.cpp
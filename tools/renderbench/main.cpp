@@ -0,0 +1,229 @@
+// Measures how long MainWindow takes to paint. The window is rendered into a
+// QImage under the offscreen platform plugin, so no display is needed.
+//
+// Usage: renderbench [--frames N] [--sizes WxH,...] [--dpr R,...]
+//                    [--variant classic|qubic|ultimate|all] [--seed S]
+//
+// Every variant is rendered at every window size and device pixel ratio,
+// with the empty board and with a quarter, half and three quarters of the
+// squares filled by random moves from a fixed seed. Each case prints the
+// mean and percentiles of the frame times in microseconds.
+
+#include "mainwindow.h"
+#include "gamestate.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+constexpr int kDefaultNumFrames = 200;
+// Frames rendered before timing starts, to warm up caches.
+constexpr int kNumWarmupFrames = 10;
+constexpr int kNumFillLevels = 4;
+constexpr int kMaxPositionAttempts = 100;
+const QString kDefaultSizes = QString("640x480,1280x720,1920x1080,3840x2160");
+const QString kDefaultDevicePixelRatios = QString("1,2");
+
+struct BenchOptions {
+    int num_frames = kDefaultNumFrames;
+    QVector<QSize> sizes;
+    QVector<qreal> device_pixel_ratios;
+    QVector<GameVariant> variants;
+    unsigned int seed = 1;
+};
+
+bool ParseSizes(const QString& text, QVector<QSize>* sizes) {
+    for (const QString& size : text.split(',')) {
+        QStringList parts = size.split('x');
+        if (parts.size() != 2 || parts[0].toInt() <= 0 || parts[1].toInt() <= 0) {
+            return false;
+        }
+        sizes->append(QSize(parts[0].toInt(), parts[1].toInt()));
+    }
+    return true;
+}
+
+bool ParseDevicePixelRatios(const QString& text, QVector<qreal>* ratios) {
+    for (const QString& ratio : text.split(',')) {
+        if (ratio.toDouble() <= 0) {
+            return false;
+        }
+        ratios->append(ratio.toDouble());
+    }
+    return true;
+}
+
+bool ParseVariants(const QString& text, QVector<GameVariant>* variants) {
+    if (text == "classic" || text == "all") {
+        variants->append(GameVariant::kClassic);
+    }
+    if (text == "qubic" || text == "all") {
+        variants->append(GameVariant::kQubic);
+    }
+    if (text == "ultimate" || text == "all") {
+        variants->append(GameVariant::kUltimate);
+    }
+    return !variants->isEmpty();
+}
+
+bool ParseOptions(int argc, char *argv[], BenchOptions* options) {
+    QString sizes = kDefaultSizes;
+    QString ratios = kDefaultDevicePixelRatios;
+    QString variants = "all";
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[i + 1];
+        if (std::strcmp(argv[i], "--frames") == 0) {
+            options->num_frames = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--sizes") == 0) {
+            sizes = value;
+        } else if (std::strcmp(argv[i], "--dpr") == 0) {
+            ratios = value;
+        } else if (std::strcmp(argv[i], "--variant") == 0) {
+            variants = value;
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options->seed = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options->num_frames > 0 && ParseSizes(sizes, &options->sizes) &&
+            ParseDevicePixelRatios(ratios, &options->device_pixel_ratios) &&
+            ParseVariants(variants, &options->variants);
+}
+
+const char* VariantName(GameVariant variant) {
+    switch (variant) {
+    case GameVariant::kQubic:
+        return "qubic";
+    case GameVariant::kUltimate:
+        return "ultimate";
+    default:
+        return "classic";
+    }
+}
+
+std::vector<Move> GenValidMoves(const GameState& game_state) {
+    switch (game_state.GetVariant()) {
+    case GameVariant::kQubic:
+        return game_state.GetQubicBoard().GenValidMoves();
+    case GameVariant::kUltimate:
+        return game_state.GetUltimateBoard().GenValidMoves();
+    default:
+        return game_state.GetBoard().GenValidMoves();
+    }
+}
+
+// Random moves that fill num_pieces squares without finishing the game, or
+// as close to that as the attempts get.
+QVector<Move> MakePosition(GameVariant variant, int num_pieces, std::mt19937& gen) {
+    QVector<Move> best_moves;
+    for (int attempt = 0; attempt < kMaxPositionAttempts; ++attempt) {
+        GameState game_state;
+        game_state.SetVariant(variant);
+        QVector<Move> moves;
+        while (moves.size() < num_pieces) {
+            std::vector<Move> valid_moves = GenValidMoves(game_state);
+            Move move = valid_moves[gen() % valid_moves.size()];
+            game_state.MakeMove(move);
+            if (game_state.IsGameFinished()) {
+                break;
+            }
+            moves.append(move);
+        }
+        if (moves.size() > best_moves.size()) {
+            best_moves = moves;
+        }
+        if (best_moves.size() == num_pieces) {
+            break;
+        }
+    }
+    return best_moves;
+}
+
+qint64 Percentile(const QVector<qint64>& sorted_times, int percent) {
+    int rank = (sorted_times.size() * percent + 99) / 100;
+    return sorted_times[qMax(rank, 1) - 1];
+}
+
+void RenderCase(MainWindow& window, const BenchOptions& options, GameVariant variant,
+                const QSize& size, qreal device_pixel_ratio, int num_pieces) {
+    window.resize(size);
+    QApplication::processEvents();
+    QImage image(size * device_pixel_ratio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(device_pixel_ratio);
+    QVector<qint64> times;
+    QElapsedTimer timer;
+    for (int frame = 0; frame < kNumWarmupFrames + options.num_frames; ++frame) {
+        image.fill(Qt::white);
+        timer.start();
+        window.render(&image);
+        qint64 elapsed = timer.nsecsElapsed();
+        if (frame >= kNumWarmupFrames) {
+            times.append(elapsed);
+        }
+    }
+    std::sort(times.begin(), times.end());
+    qint64 total = 0;
+    for (qint64 time : times) {
+        total += time;
+    }
+    QString size_text = QString("%1x%2").arg(size.width()).arg(size.height());
+    std::cout << std::left << std::setw(9) << VariantName(variant)
+              << std::setw(13) << size_text.toStdString() << std::right
+              << std::setw(5) << device_pixel_ratio
+              << std::setw(8) << num_pieces
+              << std::setw(8) << times.size()
+              << std::setw(10) << total / times.size() / 1000
+              << std::setw(10) << Percentile(times, 50) / 1000
+              << std::setw(10) << Percentile(times, 90) / 1000
+              << std::setw(10) << Percentile(times, 99) / 1000
+              << std::setw(10) << times.last() / 1000 << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Must be set before QApplication picks the platform plugin.
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        qDebug() << "Usage: renderbench [--frames N] [--sizes WxH,...] [--dpr R,...]"
+                    " [--variant classic|qubic|ultimate|all] [--seed S]";
+        return 1;
+    }
+    MainWindow window;
+    window.show();
+    std::mt19937 gen(options.seed);
+    std::cout << std::left << std::setw(9) << "variant" << std::setw(13) << "size" << std::right
+              << std::setw(5) << "dpr" << std::setw(8) << "pieces" << std::setw(8) << "frames"
+              << std::setw(10) << "mean_us" << std::setw(10) << "p50_us" << std::setw(10) << "p90_us"
+              << std::setw(10) << "p99_us" << std::setw(10) << "max_us" << std::endl;
+    for (GameVariant variant : options.variants) {
+        window.GetGameState().SetVariant(variant);
+        int num_squares = window.GetGameState().NumRows() * window.GetGameState().NumCols();
+        for (int level = 0; level < kNumFillLevels; ++level) {
+            QVector<Move> moves = MakePosition(variant, num_squares * level / kNumFillLevels, gen);
+            window.GetGameState().SetVariant(variant);
+            for (const Move& move : moves) {
+                window.GetGameState().MakeMove(move);
+            }
+            for (const QSize& size : options.sizes) {
+                for (qreal device_pixel_ratio : options.device_pixel_ratios) {
+                    RenderCase(window, options, variant, size, device_pixel_ratio, moves.size());
+                }
+            }
+        }
+    }
+    return 0;
+}
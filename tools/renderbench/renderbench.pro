@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Offscreen benchmark of the MainWindow paint path.
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = renderbench
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../engine/engine.pri)
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+        main.cpp \
+    ../../mainwindow.cpp \
+    ../../simulwindow.cpp \
+    ../../hoveranalyzer.cpp \
+    ../../ponder.cpp \
+    ../../gamestate.cpp \
+    ../../startup.cpp
+
+HEADERS += \
+    ../../mainwindow.h \
+    ../../simulwindow.h \
+    ../../hoveranalyzer.h \
+    ../../ponder.h \
+    ../../gamestate.h \
+    ../../startup.h
+
+FORMS += \
+    ../../mainwindow.ui
+
+RESOURCES += \
+    ../../menu_icons.qrc